@@ -0,0 +1,186 @@
+#pragma once
+#include "ring.h"
+#include <cstdint> /* uint64_t */
+
+// Ring with at-least-once delivery: popped elements stay in an in-flight
+// window keyed by sequence number until acknowledged, and nack()/expiry
+// puts them back at the front of the ring.
+template<class T, class Allocator = std::allocator<T>>
+class AckRing : public Ring<T, Allocator> {
+public:
+    using Ring<T, Allocator>::Ring;
+    using base = Ring<T, Allocator>;
+    using sequence = uint64_t;
+    using clock = std::chrono::steady_clock;
+    using lock_guard = typename base::lock_guard;
+    using unique_lock = typename base::unique_lock;
+
+    struct Delivery {
+        sequence seq;
+        T value;
+    };
+
+    enum class Nack {
+        requeued,
+        unknown, /* not in flight: never delivered, acked or requeued */
+        full /* refused, the delivery is still in flight */
+    };
+
+    std::optional<Delivery> pop_front_ack() {
+        lock_guard lock(this->_mutex);
+        if (base::deque::empty())
+            return std::nullopt;
+        return _deliver();
+    }
+
+    std::optional<Delivery> pop_front_ack_wait_for(
+        std::chrono::duration<double> duration = 100ms) {
+        unique_lock lock(this->_mutex);
+        if (!this->_cv.wait_for(lock, duration, [&] {
+            return !base::deque::empty() || this->_closed;
+        })) {
+            return std::nullopt;
+        }
+        if (base::deque::empty())
+            return std::nullopt;
+        return _deliver();
+    }
+
+    std::optional<Delivery> pop_front_ack_wait(
+        const std::stop_token& token) {
+        std::stop_callback wake(token, [this] { this->_wake_all(); });
+        unique_lock lock(this->_mutex);
+        this->_cv.wait(lock, [&] {
+            return !base::deque::empty() || this->_closed ||
+                token.stop_requested();
+        });
+        if (base::deque::empty())
+            return std::nullopt;
+        return _deliver();
+    }
+
+    // Marks one delivery done; the window is released up to the first
+    // still-unacknowledged sequence.
+    bool ack(sequence seq) {
+        lock_guard lock(this->_mutex);
+        auto slot = _slot(seq);
+        if (!slot)
+            return false;
+        slot->value.reset();
+        --_pending;
+        _release();
+        return true;
+    }
+
+    // Cumulative acknowledgement of everything up to and including `seq`.
+    size_t ack_upto(sequence seq) {
+        lock_guard lock(this->_mutex);
+        size_t count = 0;
+        while (!_in_flight.empty() && _first <= seq) {
+            count += _in_flight.front().value.has_value();
+            _in_flight.pop_front();
+            ++_first;
+        }
+        _pending -= count;
+        _release();
+        return count;
+    }
+
+    // Returns the delivery to the front of the ring for redelivery. A
+    // requeue never evicts: with the ring full the nack is refused and the
+    // delivery stays in flight, to be nacked again or acked later.
+    Nack nack(sequence seq) {
+        {
+            lock_guard lock(this->_mutex);
+            auto slot = _slot(seq);
+            if (!slot)
+                return Nack::unknown;
+            if (!_room())
+                return Nack::full;
+            this->_admit_front(std::move(*slot->value));
+            slot->value.reset();
+            --_pending;
+            _release();
+        }
+        this->_cv.notify_one();
+        return Nack::requeued;
+    }
+
+    // Requeues deliveries older than `timeout`, oldest ending up first, as
+    // many as fit without evicting; the rest stay in flight.
+    size_t requeue_expired(std::chrono::duration<double> timeout) {
+        size_t count = 0;
+        {
+            lock_guard lock(this->_mutex);
+            auto deadline = clock::now() -
+                std::chrono::duration_cast<clock::duration>(timeout);
+            auto expired = [&](const Entry& entry) {
+                return entry.value && entry.sent <= deadline;
+            };
+            auto room = _room();
+            size_t end = 0;
+            for (size_t i = 0, fit = 0; i < _in_flight.size() && fit < room;
+                 ++i) {
+                if (expired(_in_flight[i])) {
+                    ++fit;
+                    end = i + 1;
+                }
+            }
+            for (auto i = end; i-- > 0;) {
+                auto& entry = _in_flight[i];
+                if (!expired(entry))
+                    continue;
+                this->_admit_front(std::move(*entry.value));
+                entry.value.reset();
+                ++count;
+            }
+            _pending -= count;
+            _release();
+        }
+        if (count)
+            this->_cv.notify_all();
+        return count;
+    }
+
+    size_t in_flight() {
+        lock_guard lock(this->_mutex);
+        return _pending;
+    }
+
+private:
+    struct Entry {
+        std::optional<T> value;
+        clock::time_point sent;
+    };
+
+    Delivery _deliver() {
+        auto seq = _first + _in_flight.size();
+        auto& entry = _in_flight.emplace_back(
+            Entry{this->_take_front(), clock::now()});
+        ++_pending;
+        return {seq, *entry.value};
+    }
+
+    size_t _room() const noexcept {
+        auto size = base::deque::size();
+        return size < this->_capacity ? this->_capacity - size : 0;
+    }
+
+    Entry* _slot(sequence seq) {
+        if (seq < _first || seq - _first >= _in_flight.size())
+            return nullptr;
+        auto& entry = _in_flight[seq - _first];
+        return entry.value ? &entry : nullptr;
+    }
+
+    void _release() {
+        while (!_in_flight.empty() && !_in_flight.front().value) {
+            _in_flight.pop_front();
+            ++_first;
+        }
+    }
+
+    std::deque<Entry> _in_flight;
+    sequence _first = 0;
+    size_t _pending = 0;
+};
@@ -0,0 +1,71 @@
+// Power-of-two masking against modulo indexing, for the containers that
+// take the `pow2` option. The logical capacities are deliberately not
+// powers of two, so the modulo runs are the ones that pay a division.
+// CounterRing::add() also divides the time by the bucket width and does an
+// atomic add, so its index is a small part of its cost.
+#include "claim_ring.h"
+#include "counter_ring.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+
+using bench_clock = std::chrono::steady_clock;
+
+// Best of five runs, in nanoseconds per operation.
+template <class F>
+static double measure(uint64_t operations, F&& run) {
+    double best = 1e300;
+    for (int repeat = 0; repeat < 5; ++repeat) {
+        auto start = bench_clock::now();
+        run();
+        std::chrono::duration<double, std::nano> elapsed =
+            bench_clock::now() - start;
+        best = std::min(best, elapsed.count() / operations);
+    }
+    return best;
+}
+
+static double claim_ring(bool pow2, uint64_t rounds) {
+    ClaimRing<uint64_t> ring(1000, pow2);
+    uint64_t in[64], out[64], sum = 0;
+    for (uint64_t i = 0; i < 64; ++i)
+        in[i] = i;
+    auto ns = measure(rounds * 64, [&] {
+        for (uint64_t round = 0; round < rounds; ++round) {
+            ring.push_back(in, in + 64);
+            ring.pop_front_n(out, 64);
+            sum += out[round & 63];
+        }
+    });
+    if (sum == 42) /* keep the loop alive */
+        std::puts("");
+    return ns;
+}
+
+static double counter_ring(bool pow2, uint64_t adds) {
+    using clock = std::chrono::steady_clock;
+    CounterRing<clock> ring(60, std::chrono::microseconds(1), pow2);
+    auto now = clock::time_point{};
+    auto ns = measure(adds, [&] {
+        for (uint64_t i = 0; i < adds; ++i) {
+            now += std::chrono::nanoseconds(16); /* a new bucket every 62-63 */
+            ring.add(1, now);
+        }
+    });
+    if (ring.total(std::chrono::seconds(1), now) == 42)
+        std::puts("");
+    return ns;
+}
+
+int main(int argc, char** argv) {
+    uint64_t scale = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1;
+    std::printf("%-28s %10s %10s\n", "benchmark", "modulo", "pow2");
+    std::printf("%-28s %10.2f %10.2f  ns/element\n", "ClaimRing push+pop_n",
+        claim_ring(false, 100000 * scale), claim_ring(true, 100000 * scale));
+    std::printf("%-28s %10.2f %10.2f  ns/add\n", "CounterRing add",
+        counter_ring(false, 5000000 * scale),
+        counter_ring(true, 5000000 * scale));
+    return 0;
+}
@@ -0,0 +1,111 @@
+// Ring throughput across thread counts 1..N with the hardware and
+// scheduler counters of every worker thread summed per row.
+//
+//   ring_bench [max_threads] [csv|json] [operations]
+//
+// Counters perf_event_open(2) refuses here are left empty.
+#include "ring.h"
+#include "perf_counters.h"
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using bench_clock = std::chrono::steady_clock;
+
+// Runs `work(thread)` on `threads` threads released together, each counted
+// by its own PerfCounters. The caller fills in the operations done.
+template <class F>
+static PerfReport::Row run(const std::string& name, size_t threads, F work) {
+    PerfReport::Row row{name, threads, 0, 0, {}};
+    std::mutex mutex;
+    std::atomic<size_t> ready{0};
+    std::atomic<bool> go{false};
+    std::vector<std::thread> workers;
+    for (size_t t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t] {
+            PerfCounters counters;
+            ++ready;
+            while (!go.load(std::memory_order_acquire))
+                std::this_thread::yield();
+            counters.start();
+            work(t);
+            counters.stop();
+            std::lock_guard lock(mutex);
+            row.counters += counters.read();
+        });
+    }
+    while (ready != threads)
+        std::this_thread::yield();
+    auto start = bench_clock::now();
+    go.store(true, std::memory_order_release);
+    for (auto& worker : workers)
+        worker.join();
+    row.seconds = std::chrono::duration<double>(
+        bench_clock::now() - start).count();
+    return row;
+}
+
+int main(int argc, char** argv) {
+    size_t max_threads = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 0;
+    if (!max_threads)
+        max_threads = std::max(1u, std::thread::hardware_concurrency());
+    bool json = argc > 2 && std::strcmp(argv[2], "json") == 0;
+    uint64_t operations = argc > 3 ? std::strtoull(argv[3], nullptr, 10)
+                                   : 1000000;
+
+    PerfReport report;
+    for (size_t threads = 1; threads <= max_threads; ++threads) {
+        auto each = operations / threads;
+
+        /* every thread pushes and pops the same ring */
+        Ring<uint64_t> shared(1024);
+        auto row = run("push_pop", threads, [&](size_t) {
+            for (uint64_t i = 0; i < each; ++i) {
+                shared.push_back(i);
+                shared.pop_front();
+            }
+        });
+        row.operations = shared.stats().popped;
+        report.add(row);
+
+        /* `threads` producers, one batching consumer; only what the
+           consumer got counts, elements evicted by a full ring do not */
+        Ring<uint64_t> queue(1 << 16);
+        std::atomic<size_t> producing{threads};
+        row = run("producers_batch_consumer", threads + 1,
+            [&](size_t thread) {
+                if (thread < threads) {
+                    for (uint64_t i = 0; i < each; ++i)
+                        queue.push_back(i);
+                    --producing;
+                    return;
+                }
+                std::vector<uint64_t> batch;
+                batch.reserve(64);
+                for (;;) {
+                    /* read before the pop: once it is zero every push
+                       happened, so an empty pop means drained */
+                    bool done = producing == 0;
+                    batch.clear();
+                    if (queue.pop_front_n(std::back_inserter(batch), 64))
+                        continue;
+                    if (done)
+                        break;
+                    std::this_thread::yield();
+                }
+            });
+        row.operations = queue.stats().popped;
+        report.add(row);
+    }
+    if (json)
+        report.write_json(std::cout);
+    else
+        report.write_csv(std::cout);
+    return 0;
+}
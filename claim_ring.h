@@ -0,0 +1,193 @@
+#pragma once
+#include "ring_index.h"
+#include <algorithm> /* min */
+#include <atomic> /* atomic */
+#include <array> /* array */
+#include <cstdint> /* uint64_t */
+#include <memory> /* unique_ptr */
+#include <optional> /* optional */
+#include <span> /* span */
+#include <stdexcept> /* length_error */
+#include <iterator> /* distance */
+#include <thread> /* yield */
+#include <utility> /* exchange */
+
+// Bounded multi-producer single-consumer ring where a producer reserves a
+// whole range of slots with one fetch_add. Ranges are published in claim
+// order through a single cursor, so the consumer only ever reads one atomic
+// to learn how much is ready. A claim dropped without publish() is
+// published as a skipped range, which the consumer steps over.
+template<class T>
+class ClaimRing {
+public:
+    class Claim {
+    public:
+        Claim(Claim&& that) noexcept
+            : _ring(std::exchange(that._ring, nullptr)),
+              _start(that._start), _size(that._size) {}
+
+        Claim(const Claim&) = delete;
+        Claim& operator=(const Claim&) = delete;
+        Claim& operator=(Claim&&) = delete;
+
+        // An abandoned claim is still published, otherwise every later
+        // producer would wait behind it forever, but as a skipped range:
+        // its slots may hold stale or moved-from values.
+        ~Claim() {
+            _finish(true);
+        }
+
+        size_t size() const noexcept {
+            return _size;
+        }
+
+        uint64_t sequence() const noexcept {
+            return _start;
+        }
+
+        T& operator[](size_t i) noexcept {
+            return _ring->_slots[_ring->_index(_start + i)];
+        }
+
+        // The claimed slots as at most two contiguous pieces (the range may
+        // wrap around the end of the slot array).
+        std::array<std::span<T>, 2> spans() noexcept {
+            auto first = _ring->_index(_start);
+            auto head = std::min<size_t>(_size, _ring->_index.slots() - first);
+            return {
+                std::span<T>(&_ring->_slots[first], head),
+                std::span<T>(&_ring->_slots[0], _size - head)
+            };
+        }
+
+        void publish() noexcept {
+            _finish(false);
+        }
+
+    private:
+        friend class ClaimRing;
+
+        void _finish(bool skip) noexcept {
+            if (!_ring)
+                return;
+            auto& published = _ring->_published;
+            while (published.load(std::memory_order_acquire) != _start)
+                std::this_thread::yield();
+            if (skip && _size)
+                _ring->_skips[_ring->_index(_start)] = _size;
+            published.store(_start + _size, std::memory_order_release);
+            _ring = nullptr;
+        }
+
+        Claim(ClaimRing* ring, uint64_t start, size_t size)
+            : _ring(ring), _start(start), _size(size) {}
+
+        ClaimRing* _ring;
+        uint64_t _start;
+        size_t _size;
+    };
+
+    // `pow2` rounds the slot array up to a power of two so every index is
+    // a mask; claims are still bounded by `capacity`.
+    ClaimRing(size_t capacity = 10000, bool pow2 = false)
+        : _index(capacity, pow2),
+          _capacity(_index.capacity()),
+          _slots(std::make_unique<T[]>(_index.slots())),
+          _skips(std::make_unique<size_t[]>(_index.slots())) {}
+
+    ClaimRing(const ClaimRing&) = delete;
+    ClaimRing& operator=(const ClaimRing&) = delete;
+
+    size_t max_size() const noexcept {
+        return _capacity;
+    }
+
+    // Reserves `n` consecutive slots, waiting while the consumer still
+    // holds them. Publication happens in claim order.
+    Claim claim(size_t n) {
+        if (n > _capacity)
+            throw std::length_error("ClaimRing::claim");
+        auto start = _claimed.fetch_add(n, std::memory_order_relaxed);
+        while (start + n - _consumed.load(std::memory_order_acquire) >
+               _capacity)
+            std::this_thread::yield();
+        return Claim(this, start, n);
+    }
+
+    template <class I>
+    void push_back(I first, I last) {
+        auto claim = this->claim(std::distance(first, last));
+        _index.visit([&](auto at) {
+            for (auto i = claim.sequence(); first != last; ++first, ++i)
+                _slots[at(i)] = *first;
+        });
+        claim.publish();
+    }
+
+    void push_back(T value) {
+        auto claim = this->claim(1);
+        claim[0] = std::move(value);
+        claim.publish();
+    }
+
+    // Consumer side, single thread only. Skipped ranges are stepped over
+    // and not counted.
+    template <class OutputIt>
+    size_t pop_front_n(OutputIt out, size_t n) {
+        auto head = _consumed.load(std::memory_order_relaxed);
+        auto published = _published.load(std::memory_order_acquire);
+        size_t count = 0;
+        _index.visit([&](auto at) {
+            while (head != published && count < n) {
+                auto slot = at(head);
+                if (auto skip = std::exchange(_skips[slot], 0)) {
+                    head += skip;
+                    continue;
+                }
+                *out++ = std::move(_slots[slot]);
+                ++head;
+                ++count;
+            }
+        });
+        _consumed.store(head, std::memory_order_release);
+        return count;
+    }
+
+    std::optional<T> pop_front() {
+        auto head = _consumed.load(std::memory_order_relaxed);
+        auto published = _published.load(std::memory_order_acquire);
+        std::optional<T> value;
+        while (head != published && !value) {
+            auto slot = _index(head);
+            if (auto skip = std::exchange(_skips[slot], 0)) {
+                head += skip;
+                continue;
+            }
+            value.emplace(std::move(_slots[slot]));
+            ++head;
+        }
+        _consumed.store(head, std::memory_order_release);
+        return value;
+    }
+
+    // Published and not yet consumed, skipped ranges included. _consumed
+    // is loaded first: it only grows towards _published, so the difference
+    // cannot wrap on a thread that is neither producer nor consumer.
+    size_t size() const noexcept {
+        auto consumed = _consumed.load(std::memory_order_acquire);
+        return _published.load(std::memory_order_acquire) - consumed;
+    }
+
+    bool empty() const noexcept {
+        return size() == 0;
+    }
+
+private:
+    RingIndex _index;
+    size_t _capacity;
+    std::unique_ptr<T[]> _slots;
+    std::unique_ptr<size_t[]> _skips; /* skipped range length at its start */
+    alignas(64) std::atomic<uint64_t> _claimed{0};
+    alignas(64) std::atomic<uint64_t> _published{0};
+    alignas(64) std::atomic<uint64_t> _consumed{0};
+};
@@ -0,0 +1,197 @@
+#pragma once
+#include "ring_index.h"
+#include <algorithm> /* fill */
+#include <cstdint> /* uint32_t uint64_t */
+#include <functional> /* hash equal_to */
+#include <mutex> /* lock_guard */
+#include <optional> /* optional */
+#include <utility> /* pair move */
+#include <vector> /* vector */
+
+// Fixed-capacity cache evicting by the CLOCK algorithm. Entries live in one
+// slot array walked by a hand; a hit only sets the slot's reference bit,
+// and an insert into a full cache sweeps the hand forward, clearing bits,
+// until it finds an unreferenced victim. Keys are found through an
+// open-addressing table of slot numbers with linear probing and
+// backward-shift deletion, so after construction nothing allocates.
+template<class Key, class Value, class Hash = std::hash<Key>,
+    class KeyEqual = std::equal_to<Key>>
+class ClockCache {
+public:
+    using lock_guard = std::lock_guard<std::mutex>;
+
+    struct Stats {
+        size_t size = 0;
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t evicted = 0;
+    };
+
+    ClockCache(size_t capacity = 1024)
+        : _ring(capacity),
+          _table(_ring.capacity() * 2, true),
+          _at{_table.slots() - 1},
+          _slots(_ring.slots()),
+          _referenced(_ring.slots(), 0),
+          _buckets(_table.slots(), 0) {
+        _free.reserve(_ring.slots());
+        for (size_t i = _ring.slots(); i-- > 0;)
+            _free.push_back(i);
+    }
+
+    ClockCache(const ClockCache&) = delete;
+    ClockCache& operator=(const ClockCache&) = delete;
+
+    size_t max_size() const noexcept {
+        return _ring.capacity();
+    }
+
+    size_t size() {
+        lock_guard lock(_mutex);
+        return _size;
+    }
+
+    bool empty() {
+        return size() == 0;
+    }
+
+    // A copy of the cached value; marks the entry as recently used.
+    std::optional<Value> get(const Key& key) {
+        lock_guard lock(_mutex);
+        auto bucket = _find(key);
+        if (!bucket) {
+            ++_misses;
+            return std::nullopt;
+        }
+        auto slot = _buckets[*bucket] - 1;
+        _referenced[slot] = 1;
+        ++_hits;
+        return _slots[slot]->second;
+    }
+
+    bool contains(const Key& key) {
+        lock_guard lock(_mutex);
+        return _find(key).has_value();
+    }
+
+    // Inserts or overwrites. Returns the entry evicted to make room.
+    std::optional<std::pair<Key, Value>> put(Key key, Value value) {
+        lock_guard lock(_mutex);
+        if (auto bucket = _find(key)) {
+            auto slot = _buckets[*bucket] - 1;
+            _slots[slot]->second = std::move(value);
+            _referenced[slot] = 1;
+            return std::nullopt;
+        }
+        std::optional<std::pair<Key, Value>> evicted;
+        size_t slot;
+        if (_free.empty()) {
+            slot = _sweep();
+            _unlink(*_find(_slots[slot]->first));
+            evicted = std::move(_slots[slot]);
+            ++_evicted;
+        } else {
+            slot = _free.back();
+            _free.pop_back();
+            ++_size;
+        }
+        _link(_home(key), slot);
+        _slots[slot].emplace(std::move(key), std::move(value));
+        _referenced[slot] = 0;
+        return evicted;
+    }
+
+    bool erase(const Key& key) {
+        lock_guard lock(_mutex);
+        auto bucket = _find(key);
+        if (!bucket)
+            return false;
+        auto slot = _buckets[*bucket] - 1;
+        _unlink(*bucket);
+        _slots[slot].reset();
+        _referenced[slot] = 0;
+        _free.push_back(slot);
+        --_size;
+        return true;
+    }
+
+    Stats stats() {
+        lock_guard lock(_mutex);
+        return {_size, _hits, _misses, _evicted};
+    }
+
+    void clear() {
+        lock_guard lock(_mutex);
+        _free.clear();
+        for (size_t i = _ring.slots(); i-- > 0;) {
+            _slots[i].reset();
+            _referenced[i] = 0;
+            _free.push_back(i);
+        }
+        std::fill(_buckets.begin(), _buckets.end(), 0);
+        _size = 0;
+    }
+
+private:
+    size_t _home(const Key& key) const {
+        return _at(_hash(key));
+    }
+
+    std::optional<size_t> _find(const Key& key) const {
+        for (auto bucket = _home(key); _buckets[bucket];
+             bucket = _at(bucket + 1)) {
+            if (_equal(_slots[_buckets[bucket] - 1]->first, key))
+                return bucket;
+        }
+        return std::nullopt;
+    }
+
+    void _link(size_t bucket, size_t slot) {
+        while (_buckets[bucket])
+            bucket = _at(bucket + 1);
+        _buckets[bucket] = static_cast<uint32_t>(slot + 1);
+    }
+
+    // Backward-shift deletion: pulls later members of the probe run into
+    // the hole so lookups never need tombstones.
+    void _unlink(size_t hole) {
+        _buckets[hole] = 0;
+        for (auto next = _at(hole + 1); _buckets[next];
+             next = _at(next + 1)) {
+            auto home = _home(_slots[_buckets[next] - 1]->first);
+            if (_at(next - home) >= _at(next - hole)) {
+                _buckets[hole] = _buckets[next];
+                _buckets[next] = 0;
+                hole = next;
+            }
+        }
+    }
+
+    // Every slot is in use here, so the hand never meets an empty one.
+    size_t _sweep() {
+        return _ring.visit([&](auto at) {
+            for (;;) {
+                auto slot = at(_hand++);
+                if (!_referenced[slot])
+                    return slot;
+                _referenced[slot] = 0;
+            }
+        });
+    }
+
+    RingIndex _ring;
+    RingIndex _table;
+    RingIndex::Masked _at; /* _table is always a power of two */
+    std::vector<std::optional<std::pair<Key, Value>>> _slots;
+    std::vector<uint8_t> _referenced;
+    std::vector<uint32_t> _buckets; /* slot + 1, 0 for empty */
+    std::vector<size_t> _free;
+    uint64_t _hand = 0;
+    size_t _size = 0;
+    uint64_t _hits = 0;
+    uint64_t _misses = 0;
+    uint64_t _evicted = 0;
+    [[no_unique_address]] Hash _hash;
+    [[no_unique_address]] KeyEqual _equal;
+    std::mutex _mutex;
+};
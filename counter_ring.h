@@ -0,0 +1,123 @@
+#pragma once
+#include "ring_index.h"
+#include <atomic> /* atomic */
+#include <chrono> /* steady_clock duration */
+#include <cstdint> /* uint64_t */
+#include <memory> /* unique_ptr */
+#include <algorithm> /* clamp */
+
+using namespace std::chrono_literals;
+
+// Sliding-window event counter: a fixed ring of time buckets instead of one
+// element per event. Each bucket packs its epoch tag and count into one word,
+// so a stale bucket is recycled lazily by whichever add() first sees it.
+// The tag is the low 32 bits of the epoch, so a bucket left idle for a
+// multiple of 2^32 widths (about 49 days at 1ms, 1.2 hours at 1us) would be
+// taken for current; a bucket counts at most 2^32 - 1 events.
+template<class Clock = std::chrono::steady_clock>
+class CounterRing {
+public:
+    using clock = Clock;
+    using duration = typename Clock::duration;
+
+    // `pow2` allocates a power-of-two bucket count so the rotation is a
+    // mask; queries still cover at most `buckets` widths.
+    CounterRing(size_t buckets = 60, duration width = 1s, bool pow2 = false)
+        : _index(std::clamp<size_t>(buckets, 1, _tag_mask / 8), pow2),
+          _size(_index.capacity()),
+          _width(width.count() > 0 ? width : duration(1)),
+          _buckets(std::make_unique<std::atomic<uint64_t>[]>(
+              _index.slots())) {
+        reset();
+    }
+
+    size_t buckets() const noexcept {
+        return _size;
+    }
+
+    duration width() const noexcept {
+        return _width;
+    }
+
+    void add(uint64_t n = 1) noexcept {
+        add(n, Clock::now());
+    }
+
+    // A single fetch_add unless the bucket has to be recycled; an add that
+    // races the recycling may be counted in the newer period, never dropped.
+    void add(uint64_t n, typename Clock::time_point now) noexcept {
+        auto epoch = _epoch(now);
+        auto& bucket = _buckets[_index(epoch)];
+        auto tag = epoch & _tag_mask;
+        auto word = bucket.load(std::memory_order_relaxed);
+        while ((word & _tag_mask) != tag) {
+            if (_age(word & _tag_mask, tag) <= _index.slots())
+                break; /* already recycled by a newer period */
+            if (bucket.compare_exchange_weak(word, tag + (n << _tag_bits),
+                    std::memory_order_relaxed))
+                return;
+        }
+        bucket.fetch_add(n << _tag_bits, std::memory_order_relaxed);
+    }
+
+    // Events over the last `window`, including the current partial bucket.
+    uint64_t total(duration window) const noexcept {
+        return total(window, Clock::now());
+    }
+
+    uint64_t total(duration window,
+        typename Clock::time_point now) const noexcept {
+        auto epoch = _epoch(now);
+        auto span = _span(window);
+        auto tag = epoch & _tag_mask;
+        uint64_t sum = 0;
+        for (size_t i = 0; i < _index.slots(); ++i) {
+            auto word = _buckets[i].load(std::memory_order_relaxed);
+            if (_age(tag, word & _tag_mask) < span)
+                sum += word >> _tag_bits;
+        }
+        return sum;
+    }
+
+    // Events per second over the last `window` (capped at the ring length).
+    double rate(duration window) const noexcept {
+        return rate(window, Clock::now());
+    }
+
+    double rate(duration window,
+        typename Clock::time_point now) const noexcept {
+        auto seconds = std::chrono::duration<double>(
+            _width * _span(window)).count();
+        return seconds > 0 ? total(window, now) / seconds : 0.0;
+    }
+
+    void reset() noexcept {
+        auto stale = (_epoch(Clock::now()) - _index.slots()) & _tag_mask;
+        for (size_t i = 0; i < _index.slots(); ++i)
+            _buckets[i].store(stale, std::memory_order_relaxed);
+    }
+
+private:
+    static constexpr unsigned _tag_bits = 32;
+    static constexpr uint64_t _tag_mask = (uint64_t(1) << _tag_bits) - 1;
+
+    uint64_t _epoch(typename Clock::time_point now) const noexcept {
+        return static_cast<uint64_t>(
+            now.time_since_epoch() / _width);
+    }
+
+    uint64_t _span(duration window) const noexcept {
+        auto span = static_cast<uint64_t>(
+            (window + _width - duration(1)) / _width);
+        return std::clamp<uint64_t>(span, 1, _size);
+    }
+
+    static uint64_t _age(uint64_t now, uint64_t then) noexcept {
+        return (now - then) & _tag_mask;
+    }
+
+    RingIndex _index;
+    size_t _size;
+    duration _width;
+    std::unique_ptr<std::atomic<uint64_t>[]> _buckets;
+};
@@ -0,0 +1,147 @@
+#pragma once
+#include "ring_index.h"
+#include <atomic> /* atomic */
+#include <cstdint> /* uint64_t */
+#include <initializer_list> /* initializer_list */
+#include <limits> /* numeric_limits */
+#include <memory> /* unique_ptr */
+#include <stop_token> /* stop_token */
+#include <thread> /* yield */
+#include <vector> /* vector */
+
+// Disruptor-style pipeline over one slot array. A single producer publishes
+// slots through its cursor; each stage owns a cursor of its own and a
+// barrier made of the cursors it depends on (the producer's if none), and
+// works on the slots in place. The producer reuses a slot only once every
+// terminal stage has moved past it, so elements are never copied between
+// stages. Stages must be added before the first publish.
+template<class T>
+class Disruptor {
+public:
+    class Stage {
+    public:
+        Stage(const Stage&) = delete;
+        Stage& operator=(const Stage&) = delete;
+
+        uint64_t sequence() const noexcept {
+            return _cursor.load(std::memory_order_acquire);
+        }
+
+        // Runs fn(T&, sequence) on up to `n` slots the barrier has released,
+        // then releases them to the stages behind. Returns the count.
+        template <class F>
+        size_t process(F&& fn, size_t n = 64) {
+            auto next = _cursor.load(std::memory_order_relaxed);
+            auto ready = _barrier() - next;
+            auto count = ready < n ? ready : n;
+            _owner->_index.visit([&](auto at) {
+                for (uint64_t i = 0; i < count; ++i)
+                    fn(_owner->_slots[at(next + i)], next + i);
+            });
+            _cursor.store(next + count, std::memory_order_release);
+            return count;
+        }
+
+        // Yields until something is released; returns 0 only on stop.
+        template <class F>
+        size_t process_wait(F&& fn, const std::stop_token& token,
+            size_t n = 64) {
+            while (!token.stop_requested()) {
+                if (auto count = process(fn, n))
+                    return count;
+                std::this_thread::yield();
+            }
+            return 0;
+        }
+
+    private:
+        friend class Disruptor;
+
+        Stage(Disruptor* owner, std::vector<const Stage*> dependencies)
+            : _owner(owner), _dependencies(std::move(dependencies)) {}
+
+        uint64_t _barrier() const noexcept {
+            if (_dependencies.empty())
+                return _owner->_published.load(std::memory_order_acquire);
+            auto barrier = std::numeric_limits<uint64_t>::max();
+            for (auto stage : _dependencies) {
+                auto cursor = stage->sequence();
+                barrier = cursor < barrier ? cursor : barrier;
+            }
+            return barrier;
+        }
+
+        Disruptor* _owner;
+        std::vector<const Stage*> _dependencies;
+        bool _terminal = true;
+        alignas(64) std::atomic<uint64_t> _cursor{0};
+    };
+
+    Disruptor(size_t capacity = 1024, bool pow2 = true)
+        : _index(capacity, pow2),
+          _slots(std::make_unique<T[]>(_index.slots())) {}
+
+    Disruptor(const Disruptor&) = delete;
+    Disruptor& operator=(const Disruptor&) = delete;
+
+    size_t max_size() const noexcept {
+        return _index.capacity();
+    }
+
+    Stage& add_stage(std::initializer_list<Stage*> dependencies = {}) {
+        std::vector<const Stage*> barrier;
+        for (auto stage : dependencies) {
+            stage->_terminal = false;
+            barrier.push_back(stage);
+        }
+        _stages.emplace_back(new Stage(this, std::move(barrier)));
+        return *_stages.back();
+    }
+
+    // Producer side, one thread only. Waits for the terminal stages to free
+    // the next slot, lets `fill` write it in place and publishes it.
+    template <class F>
+    uint64_t publish(F&& fill) {
+        auto next = _published.load(std::memory_order_relaxed);
+        while (next - _gate(next) >= _index.capacity())
+            std::this_thread::yield();
+        fill(_slots[_index(next)]);
+        _published.store(next + 1, std::memory_order_release);
+        return next;
+    }
+
+    template <class F>
+    bool try_publish(F&& fill) {
+        auto next = _published.load(std::memory_order_relaxed);
+        if (next - _gate(next) >= _index.capacity())
+            return false;
+        fill(_slots[_index(next)]);
+        _published.store(next + 1, std::memory_order_release);
+        return true;
+    }
+
+    uint64_t sequence() const noexcept {
+        return _published.load(std::memory_order_acquire);
+    }
+
+private:
+    // Slowest terminal stage, cached until the producer catches up to it.
+    uint64_t _gate(uint64_t next) {
+        if (next - _gate_cache < _index.capacity() || _stages.empty())
+            return _stages.empty() ? next : _gate_cache;
+        auto gate = std::numeric_limits<uint64_t>::max();
+        for (auto& stage : _stages) {
+            if (!stage->_terminal)
+                continue;
+            auto cursor = stage->sequence();
+            gate = cursor < gate ? cursor : gate;
+        }
+        return _gate_cache = gate;
+    }
+
+    RingIndex _index;
+    std::unique_ptr<T[]> _slots;
+    std::vector<std::unique_ptr<Stage>> _stages;
+    uint64_t _gate_cache = 0;
+    alignas(64) std::atomic<uint64_t> _published{0};
+};
@@ -0,0 +1,141 @@
+#pragma once
+#include "ring.h"
+#include <queue> /* priority_queue */
+
+// Earliest-deadline-first choice between rings of different request
+// classes. Each ring gets a latency budget; an element's deadline is its
+// enqueue time plus that budget. The heads' deadlines sit in a min-heap with
+// one live entry per ring, refreshed lazily from the rings' RingSignal, so a
+// pop is O(log k) in the number of rings.
+template<class T, class Allocator = std::allocator<T>>
+class EdfScheduler {
+public:
+    using ring = Ring<T, Allocator>;
+    using clock = typename ring::clock;
+    using time_point = typename clock::time_point;
+    using duration = typename clock::duration;
+    using lock_guard = std::lock_guard<std::mutex>;
+
+    struct Item {
+        size_t id;
+        T value;
+        time_point deadline;
+    };
+
+    struct Stats {
+        uint64_t served = 0;
+        uint64_t missed = 0; /* served after their deadline */
+    };
+
+    EdfScheduler() : _signal(std::make_shared<RingSignal>()) {}
+
+    EdfScheduler(const EdfScheduler&) = delete;
+    EdfScheduler& operator=(const EdfScheduler&) = delete;
+
+    // Turns on timestamps for `ring` and attaches it; returns its id.
+    size_t add(ring& r, std::chrono::duration<double> budget) {
+        size_t id;
+        {
+            lock_guard lock(_mutex);
+            id = _rings.size();
+            _rings.push_back({&r,
+                std::chrono::duration_cast<duration>(budget),
+                std::nullopt, {}});
+        }
+        r.set_timestamps(true);
+        r.set_signal(_signal, id);
+        return id;
+    }
+
+    // Pops the most urgent head across all rings, without waiting.
+    std::optional<Item> pop() {
+        lock_guard lock(_mutex);
+        _refresh(_signal->take());
+        return _pop();
+    }
+
+    // Parks on all rings at once until one of them has an element.
+    std::optional<Item> pop_wait(const std::stop_token& token) {
+        while (!token.stop_requested()) {
+            {
+                lock_guard lock(_mutex);
+                _refresh(_signal->take());
+                if (auto item = _pop())
+                    return item;
+            }
+            auto ids = _signal->wait(token);
+            lock_guard lock(_mutex);
+            _refresh(ids);
+        }
+        return std::nullopt;
+    }
+
+    Stats stats(size_t id) {
+        lock_guard lock(_mutex);
+        return id < _rings.size() ? _rings[id].stats : Stats{};
+    }
+
+private:
+    struct Class {
+        ring* target;
+        duration budget;
+        std::optional<time_point> live; /* deadline in the heap */
+        Stats stats;
+    };
+
+    using Entry = std::pair<time_point, size_t>;
+
+    void _refresh(const std::vector<size_t>& ids) {
+        for (auto id : ids)
+            if (id < _rings.size())
+                _update(id);
+    }
+
+    void _update(size_t id) {
+        auto& c = _rings[id];
+        auto front = c.target->front_time();
+        if (!front) {
+            c.live.reset();
+            return;
+        }
+        auto deadline = *front + c.budget;
+        if (c.live == deadline)
+            return;
+        c.live = deadline;
+        _heap.push({deadline, id});
+    }
+
+    std::optional<Item> _pop() {
+        while (!_heap.empty()) {
+            auto [deadline, id] = _heap.top();
+            _heap.pop();
+            auto& c = _rings[id];
+            if (c.live != deadline)
+                continue; /* superseded entry */
+            auto front = c.target->front_time();
+            if (!front || *front + c.budget != deadline) {
+                c.live.reset();
+                _update(id); /* the head moved since it was queued */
+                continue;
+            }
+            auto popped = c.target->pop_front_timed();
+            if (!popped) {
+                c.live.reset();
+                continue;
+            }
+            deadline = popped->first + c.budget;
+            c.live.reset();
+            _update(id);
+            ++c.stats.served;
+            if (clock::now() > deadline)
+                ++c.stats.missed;
+            return Item{id, std::move(popped->second), deadline};
+        }
+        return std::nullopt;
+    }
+
+    std::shared_ptr<RingSignal> _signal;
+    std::vector<Class> _rings;
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> _heap;
+    std::mutex _mutex;
+};
@@ -0,0 +1,234 @@
+#pragma once
+#include <algorithm> /* max find */
+#include <chrono> /* duration */
+#include <condition_variable> /* condition_variable */
+#include <cstdint> /* uint64_t int64_t */
+#include <deque> /* deque */
+#include <mutex> /* lock_guard unique_lock */
+#include <optional> /* optional */
+#include <stop_token> /* stop_token stop_callback */
+#include <unordered_map> /* unordered_map */
+
+using namespace std::chrono_literals;
+
+// Ring shared by many tenants: every tenant gets its own lazily created
+// sub-queue with its own cap, pops are scheduled by deficit round robin
+// over the non-empty sub-queues, and when the ring as a whole overflows the
+// oldest element of the largest tenant is evicted.
+template<class T, class Tenant = uint64_t>
+class FairRing {
+public:
+    using lock_guard = std::lock_guard<std::mutex>;
+    using unique_lock = std::unique_lock<std::mutex>;
+
+    struct Stats {
+        size_t size = 0;
+        size_t tenants = 0; /* with queued elements */
+        uint64_t evicted = 0;
+        size_t known = 0; /* kept in memory: queued or weighted */
+    };
+
+    FairRing(size_t capacity = 10000, size_t tenant_capacity = 10000)
+        : _capacity(capacity), _tenant_capacity(tenant_capacity) {}
+
+    FairRing(const FairRing&) = delete;
+    FairRing& operator=(const FairRing&) = delete;
+
+    size_t max_size() const noexcept {
+        return _capacity;
+    }
+
+    size_t size() {
+        lock_guard lock(_mutex);
+        return _size;
+    }
+
+    bool empty() {
+        return size() == 0;
+    }
+
+    size_t size(const Tenant& tenant) {
+        lock_guard lock(_mutex);
+        auto it = _queues.find(tenant);
+        return it == _queues.end() ? 0 : it->second.items.size();
+    }
+
+    // Number of elements a tenant may take per round; at least 1.
+    void set_weight(const Tenant& tenant, size_t weight) {
+        lock_guard lock(_mutex);
+        _queues[tenant].weight = std::max<size_t>(weight, 1);
+    }
+
+    void set_tenant_capacity(size_t capacity) {
+        lock_guard lock(_mutex);
+        _tenant_capacity = capacity;
+    }
+
+    void push_back(const Tenant& tenant, T&& value) {
+        {
+            lock_guard lock(_mutex);
+            _admit(tenant, std::move(value));
+        }
+        _cv.notify_one();
+    }
+
+    void push_back(const Tenant& tenant, const T& value) {
+        {
+            lock_guard lock(_mutex);
+            _admit(tenant, value);
+        }
+        _cv.notify_one();
+    }
+
+    template <class... Args>
+    void emplace_back(const Tenant& tenant, Args&&... args) {
+        {
+            lock_guard lock(_mutex);
+            _admit(tenant, std::forward<Args>(args)...);
+        }
+        _cv.notify_one();
+    }
+
+    std::optional<T> pop_front() {
+        lock_guard lock(_mutex);
+        if (!_size)
+            return std::nullopt;
+        return _take();
+    }
+
+    std::optional<T> pop_front_wait_for(
+        std::chrono::duration<double> duration = 100ms) {
+        unique_lock lock(_mutex);
+        if (!_cv.wait_for(lock, duration, [&] { return _size != 0; }))
+            return std::nullopt;
+        return _take();
+    }
+
+    std::optional<T> pop_front_wait(const std::stop_token& token) {
+        std::stop_callback wake(token, [this] {
+            { lock_guard lock(_mutex); }
+            _cv.notify_all();
+        });
+        unique_lock lock(_mutex);
+        _cv.wait(lock, [&] {
+            return _size != 0 || token.stop_requested();
+        });
+        if (!_size)
+            return std::nullopt;
+        return _take();
+    }
+
+    Stats stats() {
+        lock_guard lock(_mutex);
+        return {_size, _active.size(), _evicted, _queues.size()};
+    }
+
+    void clear() {
+        decltype(_queues) trash;
+        {
+            lock_guard lock(_mutex);
+            for (auto it = _queues.begin(); it != _queues.end();) {
+                auto& queue = it->second;
+                if (queue.weight == 1) {
+                    trash.insert(_queues.extract(it++));
+                    continue;
+                }
+                trash[it->first].items.swap(queue.items);
+                queue.deficit = 0;
+                queue.active = false;
+                ++it;
+            }
+            _active.clear();
+            _size = 0;
+        }
+    }
+
+private:
+    struct Queue {
+        std::deque<T> items;
+        size_t weight = 1;
+        int64_t deficit = 0;
+        bool active = false;
+    };
+
+    using Queues = std::unordered_map<Tenant, Queue>;
+
+    template <class... Args>
+    void _admit(const Tenant& tenant, Args&&... args) {
+        auto it = _queues.try_emplace(tenant).first;
+        auto& queue = it->second;
+        queue.items.emplace_back(std::forward<Args>(args)...);
+        ++_size;
+        if (!queue.active) {
+            queue.active = true;
+            _active.push_back(tenant);
+        }
+        if (queue.items.size() > _tenant_capacity) {
+            _evict(it);
+        } else if (_size > _capacity) {
+            auto largest = it;
+            for (auto& active : _active) {
+                auto candidate = _queues.find(active);
+                if (candidate->second.items.size() >
+                    largest->second.items.size())
+                    largest = candidate;
+            }
+            _evict(largest);
+        }
+    }
+
+    // A queue emptied by eviction leaves the active list and is pruned
+    // right away, so the active list only holds non-empty queues.
+    void _evict(typename Queues::iterator it) {
+        auto& queue = it->second;
+        queue.items.pop_front();
+        --_size;
+        ++_evicted;
+        if (queue.items.empty()) {
+            _active.erase(std::find(_active.begin(), _active.end(),
+                it->first));
+            _prune(it);
+        }
+    }
+
+    T _take() {
+        auto tenant = _active.front();
+        auto it = _queues.find(tenant);
+        auto& queue = it->second;
+        if (queue.deficit <= 0)
+            queue.deficit += static_cast<int64_t>(queue.weight);
+        T value = std::move(queue.items.front());
+        queue.items.pop_front();
+        --_size;
+        --queue.deficit;
+        if (queue.items.empty()) {
+            _active.pop_front();
+            _prune(it);
+        } else if (queue.deficit <= 0) {
+            _active.pop_front();
+            _active.push_back(tenant);
+        }
+        return value;
+    }
+
+    // Forgets a drained tenant unless it carries a weight, so per-connection
+    // tenant ids do not pile up in the map.
+    void _prune(typename Queues::iterator it) {
+        auto& queue = it->second;
+        if (queue.weight == 1) {
+            _queues.erase(it);
+            return;
+        }
+        queue.deficit = 0;
+        queue.active = false;
+    }
+
+    size_t _capacity;
+    size_t _tenant_capacity;
+    size_t _size = 0;
+    uint64_t _evicted = 0;
+    Queues _queues;
+    std::deque<Tenant> _active;
+    std::mutex _mutex;
+    std::condition_variable _cv;
+};
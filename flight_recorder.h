@@ -0,0 +1,158 @@
+#pragma once
+#include "ring_index.h"
+#include <atomic> /* atomic */
+#include <cerrno> /* errno EINTR */
+#include <cstdint> /* uint64_t */
+#include <cstring> /* memcpy memset */
+#include <memory> /* unique_ptr */
+#include <type_traits> /* is_trivially_copyable_v */
+#include <unistd.h> /* write */
+
+// Layout of a FlightRecorder dump: this header, then `count` entries of an
+// 8-byte sequence number followed by `record_size` bytes, oldest first. An
+// entry whose slot was overwritten or half-written while it was being
+// copied has the sequence `torn` and a zeroed record. Every field is a
+// native-endian uint64_t.
+struct FlightRecorderHeader {
+    static constexpr uint64_t signature = 0x3130524654474c46; /* FLGTFR01 */
+    static constexpr uint64_t torn = ~uint64_t(0);
+
+    uint64_t magic = signature;
+    uint64_t record_size = 0;
+    uint64_t slots = 0;
+    uint64_t next = 0; /* sequence the next push would get */
+    uint64_t count = 0;
+};
+
+// Keeps the last N trivially copyable records for post-mortem dumps. A push
+// is one fetch_add, a memcpy and two stores into storage allocated up
+// front, so it is lock-free and async-signal-safe and may race any number
+// of other pushes. Each slot carries a seqlock-style stamp: a push claims
+// its slot with a CAS from an older finished stamp, so only one writer is
+// ever inside a slot, and dump() checks the stamp around its copy. A push
+// that finds its slot already lapped, or still held by a writer one lap
+// behind after a short spin, drops its record and returns false; dump()
+// reports that sequence as torn.
+template<class T>
+class FlightRecorder {
+public:
+    static_assert(std::is_trivially_copyable_v<T>,
+        "FlightRecorder needs a trivially copyable record");
+    static_assert(std::atomic<uint64_t>::is_always_lock_free,
+        "FlightRecorder needs lock-free 64-bit atomics");
+
+    // `capacity` is rounded up to a power of two, and that many are kept.
+    FlightRecorder(size_t capacity = 4096)
+        : _index(capacity, true),
+          _at{_index.slots() - 1},
+          _slots(std::make_unique<Slot[]>(_index.slots())) {}
+
+    FlightRecorder(const FlightRecorder&) = delete;
+    FlightRecorder& operator=(const FlightRecorder&) = delete;
+
+    size_t max_size() const noexcept {
+        return _index.slots();
+    }
+
+    bool push(const T& record) noexcept {
+        auto sequence = _next.fetch_add(1, std::memory_order_relaxed);
+        auto& slot = _slots[_at(sequence)];
+        auto stamp = slot.stamp.load(std::memory_order_relaxed);
+        for (unsigned spins = 0;;) {
+            if (stamp != _empty) {
+                if ((stamp & ~_busy) >= sequence)
+                    return false; /* lapped by a newer push */
+                if (stamp & _busy) {
+                    /* the previous lap is still copying its record in */
+                    if (++spins > _spins)
+                        return false;
+                    stamp = slot.stamp.load(std::memory_order_relaxed);
+                    continue;
+                }
+            }
+            if (slot.stamp.compare_exchange_weak(stamp, sequence | _busy,
+                    std::memory_order_relaxed))
+                break;
+        }
+        std::atomic_thread_fence(std::memory_order_release);
+        std::memcpy(slot.data, &record, sizeof(T));
+        slot.stamp.store(sequence, std::memory_order_release);
+        return true;
+    }
+
+    uint64_t pushed() const noexcept {
+        return _next.load(std::memory_order_relaxed);
+    }
+
+    // Safe inside a SIGSEGV/SIGABRT handler: no locks, no allocation, only
+    // write(2) from a stack buffer. Returns false if a write failed.
+    bool dump(int fd) const noexcept {
+        auto saved = errno;
+        auto next = _next.load(std::memory_order_acquire);
+        auto slots = static_cast<uint64_t>(_index.slots());
+        auto first = next > slots ? next - slots : 0;
+        FlightRecorderHeader header;
+        header.record_size = sizeof(T);
+        header.slots = slots;
+        header.next = next;
+        header.count = next - first;
+        auto ok = _write(fd, &header, sizeof(header));
+
+        alignas(uint64_t) unsigned char buffer[_buffer];
+        size_t used = 0;
+        for (auto sequence = first; ok && sequence < next; ++sequence) {
+            if (used + _entry > sizeof(buffer)) {
+                ok = _write(fd, buffer, used);
+                used = 0;
+            }
+            auto& slot = _slots[_at(sequence)];
+            auto entry = buffer + used;
+            auto stamp = slot.stamp.load(std::memory_order_acquire);
+            std::memcpy(entry + sizeof(uint64_t), slot.data, sizeof(T));
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (stamp != sequence ||
+                slot.stamp.load(std::memory_order_relaxed) != sequence) {
+                stamp = FlightRecorderHeader::torn;
+                std::memset(entry + sizeof(uint64_t), 0, sizeof(T));
+            }
+            std::memcpy(entry, &stamp, sizeof(stamp));
+            used += _entry;
+        }
+        ok = ok && _write(fd, buffer, used);
+        errno = saved;
+        return ok;
+    }
+
+private:
+    struct Slot {
+        std::atomic<uint64_t> stamp{_empty};
+        alignas(T) unsigned char data[sizeof(T)];
+    };
+
+    /* a stamp is the finished sequence, or the writer's sequence | _busy */
+    static constexpr uint64_t _empty = FlightRecorderHeader::torn;
+    static constexpr uint64_t _busy = uint64_t(1) << 63;
+    static constexpr unsigned _spins = 1024;
+    static constexpr size_t _entry = sizeof(uint64_t) + sizeof(T);
+    static constexpr size_t _buffer = _entry > 4096 ? _entry : 4096;
+
+    static bool _write(int fd, const void* data, size_t size) noexcept {
+        auto bytes = static_cast<const unsigned char*>(data);
+        while (size) {
+            auto written = ::write(fd, bytes, size);
+            if (written < 0) {
+                if (errno == EINTR)
+                    continue;
+                return false;
+            }
+            bytes += written;
+            size -= static_cast<size_t>(written);
+        }
+        return true;
+    }
+
+    RingIndex _index;
+    RingIndex::Masked _at;
+    std::unique_ptr<Slot[]> _slots;
+    alignas(64) std::atomic<uint64_t> _next{0};
+};
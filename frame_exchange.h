@@ -0,0 +1,209 @@
+#pragma once
+#include <chrono> /* duration */
+#include <condition_variable> /* condition_variable */
+#include <cstdint> /* uint64_t */
+#include <deque> /* deque */
+#include <mutex> /* lock_guard unique_lock */
+#include <optional> /* optional */
+#include <stop_token> /* stop_token stop_callback */
+#include <utility> /* exchange */
+#include <vector> /* vector */
+
+using namespace std::chrono_literals;
+
+// N-buffer exchange of whole frames between one producer and one consumer.
+// Frames are allocated once up front and only their indices move between
+// the free list and the published queue, so a frame is never copied. When
+// the consumer lags, the producer recycles the oldest published frame and
+// the loss shows up in stats().dropped.
+template<class Frame>
+class FrameExchange {
+public:
+    using lock_guard = std::lock_guard<std::mutex>;
+    using unique_lock = std::unique_lock<std::mutex>;
+
+    struct Stats {
+        uint64_t published = 0;
+        uint64_t consumed = 0;
+        uint64_t dropped = 0;
+    };
+
+    template<bool Writer>
+    class Lease {
+    public:
+        Lease(Lease&& that) noexcept
+            : _exchange(std::exchange(that._exchange, nullptr)),
+              _index(that._index) {}
+
+        Lease(const Lease&) = delete;
+        Lease& operator=(const Lease&) = delete;
+        Lease& operator=(Lease&&) = delete;
+
+        // An unpublished write lease hands its buffer back untouched.
+        ~Lease() {
+            if (_exchange)
+                _exchange->_release(_index);
+        }
+
+        Frame& operator*() const noexcept {
+            return _exchange->_frames[_index];
+        }
+
+        Frame* operator->() const noexcept {
+            return &_exchange->_frames[_index];
+        }
+
+        size_t index() const noexcept {
+            return _index;
+        }
+
+        void publish() requires Writer {
+            std::exchange(_exchange, nullptr)->_publish(_index);
+        }
+
+    private:
+        friend class FrameExchange;
+
+        Lease(FrameExchange* exchange, size_t index)
+            : _exchange(exchange), _index(index) {}
+
+        FrameExchange* _exchange;
+        size_t _index;
+    };
+
+    using WriteLease = Lease<true>;
+    using ReadLease = Lease<false>;
+
+    template <class... Args>
+    FrameExchange(size_t buffers = 3, const Args&... args) {
+        buffers = buffers < 2 ? 2 : buffers;
+        _frames.reserve(buffers);
+        _free.reserve(buffers);
+        for (size_t i = 0; i < buffers; ++i) {
+            _frames.emplace_back(args...);
+            _free.push_back(i);
+        }
+    }
+
+    FrameExchange(const FrameExchange&) = delete;
+    FrameExchange& operator=(const FrameExchange&) = delete;
+
+    size_t max_size() const noexcept {
+        return _frames.size();
+    }
+
+    // Producer side. Takes a free buffer or, failing that, the oldest
+    // published frame the consumer has not picked up yet.
+    std::optional<WriteLease> acquire() {
+        lock_guard lock(_mutex);
+        if (_free.empty()) {
+            if (_ready.empty())
+                return std::nullopt;
+            _free.push_back(_ready.front());
+            _ready.pop_front();
+            ++_stats.dropped;
+        }
+        auto index = _free.back();
+        _free.pop_back();
+        return WriteLease(this, index);
+    }
+
+    // Consumer side: the newest frame, dropping anything older.
+    std::optional<ReadLease> acquire_latest() {
+        lock_guard lock(_mutex);
+        return _take_latest();
+    }
+
+    // Consumer side: the oldest frame, keeping the rest queued.
+    std::optional<ReadLease> acquire_oldest() {
+        lock_guard lock(_mutex);
+        return _take_oldest();
+    }
+
+    std::optional<ReadLease> acquire_latest_wait_for(
+        std::chrono::duration<double> duration = 100ms) {
+        unique_lock lock(_mutex);
+        _cv.wait_for(lock, duration, [&] { return !_ready.empty(); });
+        return _take_latest();
+    }
+
+    std::optional<ReadLease> acquire_oldest_wait_for(
+        std::chrono::duration<double> duration = 100ms) {
+        unique_lock lock(_mutex);
+        _cv.wait_for(lock, duration, [&] { return !_ready.empty(); });
+        return _take_oldest();
+    }
+
+    std::optional<ReadLease> acquire_latest_wait(
+        const std::stop_token& token) {
+        std::stop_callback wake(token, [this] { _wake_all(); });
+        unique_lock lock(_mutex);
+        _cv.wait(lock, [&] {
+            return !_ready.empty() || token.stop_requested();
+        });
+        return _take_latest();
+    }
+
+    std::optional<ReadLease> acquire_oldest_wait(
+        const std::stop_token& token) {
+        std::stop_callback wake(token, [this] { _wake_all(); });
+        unique_lock lock(_mutex);
+        _cv.wait(lock, [&] {
+            return !_ready.empty() || token.stop_requested();
+        });
+        return _take_oldest();
+    }
+
+    Stats stats() {
+        lock_guard lock(_mutex);
+        return _stats;
+    }
+
+private:
+    std::optional<ReadLease> _take_latest() {
+        if (_ready.empty())
+            return std::nullopt;
+        auto index = _ready.back();
+        _ready.pop_back();
+        _stats.dropped += _ready.size();
+        _free.insert(_free.end(), _ready.begin(), _ready.end());
+        _ready.clear();
+        ++_stats.consumed;
+        return ReadLease(this, index);
+    }
+
+    std::optional<ReadLease> _take_oldest() {
+        if (_ready.empty())
+            return std::nullopt;
+        auto index = _ready.front();
+        _ready.pop_front();
+        ++_stats.consumed;
+        return ReadLease(this, index);
+    }
+
+    void _publish(size_t index) {
+        {
+            lock_guard lock(_mutex);
+            _ready.push_back(index);
+            ++_stats.published;
+        }
+        _cv.notify_one();
+    }
+
+    void _release(size_t index) {
+        lock_guard lock(_mutex);
+        _free.push_back(index);
+    }
+
+    void _wake_all() {
+        { lock_guard lock(_mutex); }
+        _cv.notify_all();
+    }
+
+    std::vector<Frame> _frames;
+    std::vector<size_t> _free;
+    std::deque<size_t> _ready;
+    Stats _stats;
+    std::mutex _mutex;
+    std::condition_variable _cv;
+};
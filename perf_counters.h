@@ -0,0 +1,258 @@
+#pragma once
+#include <array> /* array */
+#include <cstdint> /* uint64_t */
+#include <optional> /* optional */
+#include <ostream> /* ostream */
+#include <string> /* string */
+#include <vector> /* vector */
+#if defined(__linux__)
+#include <linux/perf_event.h> /* perf_event_attr */
+#include <sys/ioctl.h> /* ioctl */
+#include <sys/syscall.h> /* SYS_perf_event_open */
+#include <unistd.h> /* syscall read close */
+#endif
+
+// Hardware and scheduler counters for the calling thread, read through
+// perf_event_open(2). Every event is opened on its own so that one the
+// kernel or the PMU refuses (perf_event_paranoid, containers, VMs) only
+// leaves that column empty instead of disabling the whole set.
+class PerfCounters {
+public:
+    enum Event {
+        cycles,
+        instructions,
+        l1d_misses,
+        llc_misses,
+        branch_misses,
+        context_switches,
+        events
+    };
+
+    struct Reading {
+        std::array<std::optional<uint64_t>, events> values;
+
+        Reading& operator+=(const Reading& that) {
+            for (size_t i = 0; i < events; ++i)
+                if (that.values[i])
+                    values[i] = values[i].value_or(0) + *that.values[i];
+            return *this;
+        }
+    };
+
+    static const char* name(size_t event) noexcept {
+        static const char* names[events] = {
+            "cycles", "instructions", "l1d_misses",
+            "llc_misses", "branch_misses", "context_switches"
+        };
+        return names[event];
+    }
+
+    PerfCounters() {
+        _fds.fill(-1);
+#if defined(__linux__)
+        for (size_t i = 0; i < events; ++i)
+            _fds[i] = _open(static_cast<Event>(i));
+#endif
+    }
+
+    ~PerfCounters() {
+#if defined(__linux__)
+        for (auto fd : _fds)
+            if (fd >= 0)
+                ::close(fd);
+#endif
+    }
+
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    bool available() const noexcept {
+        for (auto fd : _fds)
+            if (fd >= 0)
+                return true;
+        return false;
+    }
+
+    void start() noexcept {
+#if defined(__linux__)
+        for (auto fd : _fds) {
+            if (fd < 0)
+                continue;
+            ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+            ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+#endif
+    }
+
+    void stop() noexcept {
+#if defined(__linux__)
+        for (auto fd : _fds)
+            if (fd >= 0)
+                ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+#endif
+    }
+
+    // Values are scaled up when the kernel had to multiplex the PMU.
+    Reading read() const noexcept {
+        Reading reading;
+#if defined(__linux__)
+        for (size_t i = 0; i < events; ++i) {
+            uint64_t data[3]; /* value, time enabled, time running */
+            if (_fds[i] < 0 ||
+                ::read(_fds[i], data, sizeof(data)) != sizeof(data))
+                continue;
+            if (data[2] && data[2] < data[1])
+                data[0] = static_cast<uint64_t>(
+                    static_cast<double>(data[0]) * data[1] / data[2]);
+            reading.values[i] = data[0];
+        }
+#endif
+        return reading;
+    }
+
+private:
+#if defined(__linux__)
+    static int _open(Event event) {
+        perf_event_attr attr{};
+        attr.size = sizeof(attr);
+        attr.disabled = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED |
+            PERF_FORMAT_TOTAL_TIME_RUNNING;
+        switch (event) {
+        case cycles:
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_CPU_CYCLES;
+            break;
+        case instructions:
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+            break;
+        case l1d_misses:
+            attr.type = PERF_TYPE_HW_CACHE;
+            attr.config = PERF_COUNT_HW_CACHE_L1D |
+                (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+            break;
+        case llc_misses:
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_CACHE_MISSES;
+            break;
+        case branch_misses:
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_BRANCH_MISSES;
+            break;
+        case context_switches:
+            attr.type = PERF_TYPE_SOFTWARE;
+            attr.config = PERF_COUNT_SW_CONTEXT_SWITCHES;
+            break;
+        default:
+            return -1;
+        }
+        /* kernel-side counting first, user-only if paranoia forbids it */
+        auto fd = static_cast<int>(
+            syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+        if (fd < 0) {
+            attr.exclude_kernel = 1;
+            fd = static_cast<int>(
+                syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+        }
+        return fd;
+    }
+#endif
+
+    std::array<int, events> _fds;
+};
+
+// Rows of one benchmark run per thread count, written out as CSV or JSON.
+// Counters that could not be opened are empty in CSV and null in JSON.
+class PerfReport {
+public:
+    struct Row {
+        std::string benchmark;
+        size_t threads = 1;
+        uint64_t operations = 0;
+        double seconds = 0;
+        PerfCounters::Reading counters;
+    };
+
+    void add(Row row) {
+        _rows.push_back(std::move(row));
+    }
+
+    const std::vector<Row>& rows() const noexcept {
+        return _rows;
+    }
+
+    void write_csv(std::ostream& out) const {
+        out << "benchmark,threads,operations,seconds";
+        for (size_t i = 0; i < PerfCounters::events; ++i)
+            out << ',' << PerfCounters::name(i);
+        out << '\n';
+        for (auto& row : _rows) {
+            _csv(out, row.benchmark);
+            out << ',' << row.threads << ','
+                << row.operations << ',' << row.seconds;
+            for (auto& value : row.counters.values) {
+                out << ',';
+                if (value)
+                    out << *value;
+            }
+            out << '\n';
+        }
+    }
+
+    void write_json(std::ostream& out) const {
+        out << "[\n";
+        for (size_t r = 0; r < _rows.size(); ++r) {
+            auto& row = _rows[r];
+            out << "  {\"benchmark\": ";
+            _json(out, row.benchmark);
+            out << ", \"threads\": " << row.threads
+                << ", \"operations\": " << row.operations
+                << ", \"seconds\": " << row.seconds;
+            for (size_t i = 0; i < PerfCounters::events; ++i) {
+                out << ", \"" << PerfCounters::name(i) << "\": ";
+                if (auto& value = row.counters.values[i])
+                    out << *value;
+                else
+                    out << "null";
+            }
+            out << (r + 1 < _rows.size() ? "},\n" : "}\n");
+        }
+        out << "]\n";
+    }
+
+private:
+    // Quoted only when it has to be, with quotes doubled (RFC 4180).
+    static void _csv(std::ostream& out, const std::string& field) {
+        if (field.find_first_of(",\"\r\n") == std::string::npos) {
+            out << field;
+            return;
+        }
+        out << '"';
+        for (auto c : field) {
+            if (c == '"')
+                out << '"';
+            out << c;
+        }
+        out << '"';
+    }
+
+    static void _json(std::ostream& out, const std::string& text) {
+        static const char hex[] = "0123456789abcdef";
+        out << '"';
+        for (auto c : text) {
+            auto byte = static_cast<unsigned char>(c);
+            if (c == '"' || c == '\\')
+                out << '\\' << c;
+            else if (byte < 0x20)
+                out << "\\u00" << hex[byte >> 4] << hex[byte & 15];
+            else
+                out << c;
+        }
+        out << '"';
+    }
+
+    std::vector<Row> _rows;
+};
@@ -6,9 +6,186 @@
 #include <mutex> /* lock_guard scoped_lock */
 #include <condition_variable> /* condition_variable */
 #include <optional> /* optional */
+#include <functional> /* function */
+#include <chrono> /* duration */
+#include <stop_token> /* stop_token stop_callback */
+#include <thread> /* jthread yield */
+#include <vector> /* vector */
+#include <span> /* span */
+#include <atomic> /* atomic */
+#include <memory> /* shared_ptr */
+#include <cmath> /* exp */
+#include <limits> /* infinity */
+#include <utility> /* exchange pair */
+#include <algorithm> /* min max */
+#include <future> /* promise future */
+#include <system_error> /* system_error */
+#include <exception> /* exception_ptr rethrow_exception */
+#include <cerrno> /* EINVAL ENOTSUP */
+#include <iterator> /* default_sentinel_t */
+#if __has_include(<generator>)
+#include <generator> /* generator */
+#endif
+#if defined(__linux__)
+#include <pthread.h> /* pthread_setaffinity_np */
+#endif
 
 using namespace std::chrono_literals;
 
+enum class WaitStrategy {
+    block, /* sleep on the ring's condition variable */
+    spin, /* busy-poll `spin` times, then block */
+    yield /* poll and yield `spin` times, then block */
+};
+
+struct ConsumerOptions {
+    size_t threads = 1;
+    size_t batch = 64;
+    std::vector<int> cpus; /* pinned round-robin, empty - no affinity */
+    WaitStrategy wait = WaitStrategy::block;
+    size_t spin = 1000;
+};
+
+class RingConsumer {
+public:
+    struct Stats {
+        uint64_t items = 0;
+        uint64_t batches = 0;
+        uint64_t waits = 0;
+    };
+
+    struct Counters {
+        std::atomic<uint64_t> items{0};
+        std::atomic<uint64_t> batches{0};
+        std::atomic<uint64_t> waits{0};
+    };
+
+    RingConsumer() = default;
+    RingConsumer(RingConsumer&&) noexcept = default;
+    RingConsumer& operator=(RingConsumer&&) noexcept = default;
+
+    ~RingConsumer() {
+        request_stop();
+        join();
+    }
+
+    void request_stop() noexcept {
+        for (auto& thread : _threads)
+            thread.request_stop();
+    }
+
+    // Only waits: the threads finish once the ring is closed and drained,
+    // or after request_stop().
+    void join() {
+        for (auto& thread : _threads)
+            if (thread.joinable())
+                thread.join();
+    }
+
+    bool joinable() const noexcept {
+        for (auto& thread : _threads)
+            if (thread.joinable())
+                return true;
+        return false;
+    }
+
+    size_t size() const noexcept {
+        return _threads.size();
+    }
+
+    Stats stats() const noexcept {
+        if (!_counters)
+            return {};
+        return {
+            _counters->items.load(std::memory_order_relaxed),
+            _counters->batches.load(std::memory_order_relaxed),
+            _counters->waits.load(std::memory_order_relaxed)
+        };
+    }
+
+private:
+    template<class, class> friend class Ring;
+
+    std::shared_ptr<Counters> _counters;
+    std::vector<std::jthread> _threads;
+};
+
+// Doorbell shared by several rings so one waiter can park on all of them.
+// A ring attached with Ring::set_signal() rings it with its id whenever its
+// head element changes.
+class RingSignal {
+public:
+    using lock_guard = std::lock_guard<std::mutex>;
+    using unique_lock = std::unique_lock<std::mutex>;
+
+    void notify(size_t id) {
+        {
+            lock_guard lock(_mutex);
+            if (id >= _pending.size())
+                _pending.resize(id + 1);
+            if (!_pending[id]) {
+                _pending[id] = true;
+                _dirty.push_back(id);
+            }
+        }
+        _cv.notify_all();
+    }
+
+    // Hands over the ids rung since the last call, without waiting.
+    std::vector<size_t> take() {
+        lock_guard lock(_mutex);
+        return _take();
+    }
+
+    // Waits until some ring has rung or `deadline` passes or `token` is
+    // stopped; returns the ids rung.
+    template <class Clock, class Duration>
+    std::vector<size_t> wait_until(const std::stop_token& token,
+        const std::chrono::time_point<Clock, Duration>& deadline) {
+        std::stop_callback wake(token, [this] {
+            { lock_guard lock(_mutex); }
+            _cv.notify_all();
+        });
+        unique_lock lock(_mutex);
+        _cv.wait_until(lock, deadline, [&] {
+            return !_dirty.empty() || token.stop_requested();
+        });
+        return _take();
+    }
+
+    std::vector<size_t> wait(const std::stop_token& token) {
+        return wait_until(token, std::chrono::steady_clock::time_point::max());
+    }
+
+private:
+    std::vector<size_t> _take() {
+        for (auto id : _dirty)
+            _pending[id] = false;
+        return std::exchange(_dirty, {});
+    }
+
+    std::mutex _mutex;
+    std::condition_variable _cv;
+    std::vector<size_t> _dirty;
+    std::vector<bool> _pending;
+};
+
+struct RingStats {
+    size_t size = 0;
+    size_t capacity = 0;
+    uint64_t pushed = 0;
+    uint64_t popped = 0;
+    uint64_t evicted = 0;
+    uint64_t dropped = 0; /* by active queue management */
+    uint64_t lifo_switches = 0;
+    uint64_t combined = 0; /* pushes merged into the back element */
+    bool lifo = false;
+    double arrival_rate = 0; /* elements per second, EWMA */
+    double service_rate = 0; /* elements per second, EWMA */
+    std::chrono::duration<double> time_to_overflow; /* infinite if draining */
+    std::chrono::duration<double> drain_eta; /* infinite if filling */
+};
+
 template<class T, class Allocator = std::allocator<T>>
 class Ring : public std::deque<T, Allocator>
         {
@@ -16,6 +193,7 @@ public:
     using deque = std::deque<T, Allocator>;
     using lock_guard = std::lock_guard<std::mutex>;
     using unique_lock = std::unique_lock<std::mutex>;
+    using clock = std::chrono::steady_clock;
 
     Ring(size_t capacity = 10000) : _capacity(capacity) {}
 
@@ -35,62 +213,79 @@ public:
     }
 
     void resize(size_t size) {
-        lock_guard lock(_mutex);
-        if (_capacity > size)
-            deque::resize(size);
-        _capacity = size;
+        deque trash(deque::get_allocator());
+        {
+            lock_guard lock(_mutex);
+            if (deque::size() > size)
+                _truncate(size, trash);
+            _capacity = size;
+        }
     }
 
     void push_front(T &&value) {
         lock_guard lock(_mutex);
-        deque::push_front(value);
-        if (deque::size() > _capacity)
-            deque::pop_back();
+        _admit_front(std::move(value));
         _cv.notify_one();
     }
 
     void push_front(const T &value) {
         lock_guard lock(_mutex);
-        deque::push_front(value);
-        if (deque::size() > _capacity)
-            deque::pop_back();
+        _admit_front(value);
         _cv.notify_one();
     }
 
     template <class... Args>
     void emplace_front(Args&&... args) {
         lock_guard lock(_mutex);
-        deque::emplace_front(std::forward<Args>(args)...);
-        if (deque::size() > _capacity)
-            deque::pop_back();
+        _admit_front(std::forward<Args>(args)...);
         _cv.notify_one();
     }
 
     void push_back(T &&value) {
         lock_guard lock(_mutex);
-        deque::push_back(value);
-        if (deque::size() > _capacity)
-            deque::pop_front();
+        if (_combine_back(value))
+            return;
+        _admit_back(std::move(value));
         _cv.notify_one();
     }
 
     void push_back(const T &value) {
         lock_guard lock(_mutex);
-        deque::push_back(value);
-        if (deque::size() > _capacity)
-            deque::pop_front();
+        if (_combine_back(value))
+            return;
+        _admit_back(value);
         _cv.notify_one();
     }
 
     template <class... Args>
     void emplace_back(Args&&... args) {
         lock_guard lock(_mutex);
-        deque::emplace_back(std::forward<Args>(args)...);
-        if (deque::size() > _capacity)
-            deque::pop_front();
+        _admit_back(std::forward<Args>(args)...);
         _cv.notify_one();
     }
 
+    // Pushes [first, last) under one lock and wakes consumers once. Pass
+    // move iterators to move the elements in. Returns how many were
+    // admitted rather than merged by the combiner.
+    template <class I>
+    size_t push_back_n(I first, I last) {
+        size_t count = 0;
+        {
+            lock_guard lock(_mutex);
+            for (; first != last; ++first) {
+                if (_combine_back(*first))
+                    continue;
+                _admit_back(*first);
+                ++count;
+            }
+        }
+        if (count == 1)
+            _cv.notify_one();
+        else if (count)
+            _cv.notify_all();
+        return count;
+    }
+
     void shrink_to_fit() {
         lock_guard lock(_mutex);
         deque::shrink_to_fit();
@@ -101,18 +296,14 @@ public:
         lock_guard lock(_mutex);
         if (deque::empty())
             return std::nullopt;
-        T value = std::move(deque::front());
-        deque::pop_front();
-        return value;
+        return _take_front();
     }
 
     std::optional<T> pop_back() {
         lock_guard lock(_mutex);
         if (deque::empty())
             return std::nullopt;
-        T value = std::move(deque::back());
-        deque::pop_back();
-        return value;
+        return _take_back();
     }
 
     std::optional<T> pop_front_wait_for(
@@ -120,16 +311,16 @@ public:
         unique_lock lock(_mutex);
         for (;;) {
             if (!_cv.wait_for(lock, duration, [&] {
-                return !deque::empty();
+                return !deque::empty() || _closed;
             })) {
                 return std::nullopt;
             } else {
                 break;
             }
         }
-        T value = std::move(deque::front());
-        deque::pop_front();
-        return value;
+        if (deque::empty())
+            return std::nullopt;
+        return _take_front();
     }
 
     std::optional<T> pop_back_wait_for(
@@ -137,100 +328,496 @@ public:
         unique_lock lock(_mutex);
         for (;;) {
             if (!_cv.wait_for(lock, duration, [&] {
-                return !deque::empty();
+                return !deque::empty() || _closed;
             })) {
                 return std::nullopt;
             } else {
                 break;
             }
         }
-        T value = std::move(deque::back());
-        deque::pop_back();
-        return value;
+        if (deque::empty())
+            return std::nullopt;
+        return _take_back();
     }
 
     std::optional<T> pop_front_wait(
         const std::function<bool()>& isRunning) {
         unique_lock lock(_mutex);
         _cv.wait(lock, [&] {
-            return !deque::empty() || !isRunning();
+            return !deque::empty() || _closed || !isRunning();
         });
         if (deque::empty())
             return std::nullopt;
-        T value = std::move(deque::front());
-        deque::pop_front();
-        return value;
+        return _take_front();
     }
 
     std::optional<T> pop_back_wait(
         const std::function<bool()>& isRunning) {
         unique_lock lock(_mutex);
         _cv.wait(lock, [&] {
-            return !deque::empty() || !isRunning();
+            return !deque::empty() || _closed || !isRunning();
         });
         if (!isRunning() ||
             deque::empty()) {
             return std::nullopt;
         }
-        T value = std::move(deque::back());
-        deque::pop_back();
-        return value;
+        return _take_back();
     }
 
     std::optional<T> pop_front_wait(
         const std::stop_token& token) {
+        std::stop_callback wake(token, [this] { _wake_all(); });
         unique_lock lock(_mutex);
         _cv.wait(lock, [&] {
-            return !deque::empty() ||
+            return !deque::empty() || _closed ||
                 token.stop_requested();
         });
         if (deque::empty())
             return std::nullopt;
-        T value = std::move(deque::front());
-        deque::pop_front();
-        return value;
+        return _take_front();
     }
 
     std::optional<T> pop_back_wait(
        const std::stop_token&& token) {
+        std::stop_callback wake(token, [this] { _wake_all(); });
         unique_lock lock(_mutex);
         _cv.wait(lock, [&] {
-            return !deque::empty() ||
+            return !deque::empty() || _closed ||
                 token.stop_requested();
         });
         if (token.stop_requested() ||
             deque::empty()) {
             return std::nullopt;
         }
-        T value = std::move(deque::back());
-        deque::pop_back();
+        return _take_back();
+    }
+
+    template <class OutputIt>
+    size_t pop_front_n(OutputIt out, size_t n) {
+        lock_guard lock(_mutex);
+        return _take_front_n(out, n);
+    }
+
+    template <class OutputIt>
+    size_t pop_front_wait_n(OutputIt out, size_t n,
+        const std::stop_token& token) {
+        std::stop_callback wake(token, [this] { _wake_all(); });
+        unique_lock lock(_mutex);
+        _cv.wait(lock, [&] {
+            return !deque::empty() || _closed ||
+                token.stop_requested();
+        });
+        return _take_front_n(out, n);
+    }
+
+    // The predicates below run under the ring's lock and must not call back
+    // into it.
+
+    // Pops the head only if it matches; AQM is not consulted, so the
+    // element returned is the one `pred` saw.
+    template <class Pred>
+    std::optional<T> pop_front_if(Pred pred) {
+        lock_guard lock(_mutex);
+        if (deque::empty() || !pred(std::as_const(deque::front())))
+            return std::nullopt;
+        T value = std::move(deque::front());
+        _drop_front();
+        _bump(_popped);
         return value;
     }
 
+    // Removes every match, keeping the order of the rest, in one pass.
+    // Returns the number removed. If `pred` throws, the matches before the
+    // element it threw on are removed, everything else stays, and the
+    // exception is rethrown.
+    template <class Pred>
+    size_t erase_if(Pred pred) {
+        deque trash(deque::get_allocator());
+        std::exception_ptr failure;
+        size_t erased;
+        {
+            lock_guard lock(_mutex);
+            auto size = deque::size();
+            auto kept = _compact(pred, failure);
+            erased = size - kept;
+            if (erased)
+                _truncate(kept, trash);
+        }
+        if (erased)
+            _signal_head();
+        if (failure)
+            std::rethrow_exception(failure);
+        return erased;
+    }
+
+    template <class Pred>
+    size_t count_if(Pred pred) {
+        lock_guard lock(_mutex);
+        size_t count = 0;
+        for (auto& value : static_cast<const deque&>(*this))
+            count += static_cast<bool>(pred(value));
+        return count;
+    }
+
+    // Wakes every waiter; blocking pops return nullopt once the ring is
+    // closed and drained. Pushes are still accepted.
+    void close() {
+        {
+            lock_guard lock(_mutex);
+            _closed = true;
+        }
+        _cv.notify_all();
+        _pace_cv.notify_all();
+    }
+
+    bool closed() {
+        lock_guard lock(_mutex);
+        return _closed;
+    }
+
+    // Input range that drains the ring in batches of up to `batch` elements
+    // per lock and yields them one at a time. It ends once the ring is
+    // closed and drained, or on stop after the batch in hand, leaving the
+    // rest queued.
+    class ConsumeRange {
+    public:
+        class iterator {
+        public:
+            using value_type = T;
+            using difference_type = std::ptrdiff_t;
+
+            iterator() = default;
+
+            T& operator*() const {
+                return _range->_batch[_range->_position];
+            }
+
+            iterator& operator++() {
+                if (++_range->_position == _range->_batch.size())
+                    _range->_refill();
+                return *this;
+            }
+
+            void operator++(int) {
+                ++*this;
+            }
+
+            // A default-constructed iterator is already at the end.
+            bool operator==(std::default_sentinel_t) const {
+                return !_range || _range->_batch.empty();
+            }
+
+        private:
+            friend class ConsumeRange;
+
+            explicit iterator(ConsumeRange* range) : _range(range) {}
+
+            ConsumeRange* _range = nullptr;
+        };
+
+        iterator begin() {
+            _refill();
+            return iterator(this);
+        }
+
+        std::default_sentinel_t end() const noexcept {
+            return {};
+        }
+
+    private:
+        friend class Ring;
+
+        ConsumeRange(Ring& ring, std::stop_token token, size_t batch)
+            : _ring(ring), _token(std::move(token)),
+              _limit(batch ? batch : 1) {
+            _batch.reserve(_limit);
+        }
+
+        void _refill() {
+            _batch.clear();
+            _position = 0;
+            if (!_token.stop_requested())
+                _ring.pop_front_wait_n(std::back_inserter(_batch), _limit,
+                    _token);
+        }
+
+        Ring& _ring;
+        std::stop_token _token;
+        size_t _limit;
+        std::vector<T> _batch;
+        size_t _position = 0;
+    };
+
+    ConsumeRange consume(std::stop_token token = {}, size_t batch = 64) {
+        return ConsumeRange(*this, std::move(token), batch);
+    }
+
+#if defined(__cpp_lib_generator)
+    std::generator<T&&> consume_generator(std::stop_token token = {},
+        size_t batch = 64) {
+        std::vector<T> values;
+        values.reserve(batch ? batch : 1);
+        while (!token.stop_requested() &&
+               pop_front_wait_n(std::back_inserter(values),
+                   batch ? batch : 1, token)) {
+            for (auto& value : values)
+                co_yield std::move(value);
+            values.clear();
+        }
+    }
+#endif
+
+    // Token-bucket shaped pop: the ring releases at most `rate` elements
+    // per second on average with bursts of up to `burst`. Parks until both
+    // a token and an element are there; returns nullopt on stop, once the
+    // ring is closed and drained, or once it is closed while `rate` is 0.
+    std::optional<T> pop_front_paced(double rate, double burst,
+        const std::stop_token& token) {
+        std::stop_callback wake(token, [this] { _wake_all(); });
+        unique_lock lock(_mutex);
+        if (!_pace_wait(lock, rate, burst, token))
+            return std::nullopt;
+        _pace_tokens -= 1;
+        return _take_front();
+    }
+
+    // Batch form for high rates: takes as many elements as there are whole
+    // tokens, up to `n`, under one lock.
+    template <class OutputIt>
+    size_t pop_front_paced_n(OutputIt out, size_t n, double rate,
+        double burst, const std::stop_token& token) {
+        std::stop_callback wake(token, [this] { _wake_all(); });
+        unique_lock lock(_mutex);
+        auto tokens = _pace_wait(lock, rate, burst, token);
+        auto count = _take_front_n(out, std::min<size_t>(n, tokens));
+        _pace_tokens -= count;
+        return count;
+    }
+
+    // Runs `fn` on `options.threads` jthreads until the handle is stopped,
+    // or until the ring is closed and drained. `fn` takes either a
+    // std::span<T> of up to `options.batch` elements or a single T&&. Each
+    // thread pins itself before its first pop; if any cannot, all are
+    // stopped and std::system_error is thrown.
+    template <class F>
+    RingConsumer spawn_consumer(F fn, ConsumerOptions options = {}) {
+        RingConsumer consumer;
+        consumer._counters = std::make_shared<RingConsumer::Counters>();
+        auto threads = options.threads ? options.threads : 1;
+        std::vector<std::future<int>> pinned;
+        for (size_t i = 0; i < threads; ++i) {
+            std::promise<int> pin;
+            if (!options.cpus.empty())
+                pinned.push_back(pin.get_future());
+            consumer._threads.emplace_back(
+                [this, fn, options, i, pin = std::move(pin),
+                    counters = consumer._counters]
+                (std::stop_token token) mutable {
+                    if (!options.cpus.empty()) {
+                        auto error = _pin(options.cpus[i % options.cpus.size()]);
+                        pin.set_value(error);
+                        if (error)
+                            return;
+                    }
+                    _consume(token, fn, options, *counters);
+                });
+        }
+        for (auto& pin : pinned)
+            if (auto error = pin.get())
+                throw std::system_error(error, std::generic_category(),
+                    "Ring::spawn_consumer: cannot pin to CPU");
+        return consumer;
+    }
+
+    // Time constant of the arrival/service rate EWMAs.
+    void set_rate_window(std::chrono::duration<double> window) {
+        lock_guard lock(_mutex);
+        _rate_window = window;
+    }
+
+    RingStats stats() {
+        lock_guard lock(_mutex);
+        _sample(clock::now());
+        RingStats stats;
+        stats.size = deque::size();
+        stats.capacity = _capacity;
+        stats.pushed = _pushed.load(std::memory_order_relaxed);
+        stats.popped = _popped.load(std::memory_order_relaxed);
+        stats.evicted = _evicted.load(std::memory_order_relaxed);
+        stats.dropped = _dropped.load(std::memory_order_relaxed);
+        stats.lifo_switches = _lifo_switches;
+        stats.lifo = _lifo;
+        stats.combined = _combined;
+        stats.arrival_rate = _arrival_rate.load(std::memory_order_relaxed);
+        stats.service_rate = _service_rate.load(std::memory_order_relaxed);
+        stats.time_to_overflow = _eta(_capacity - stats.size,
+            stats.arrival_rate - stats.service_rate);
+        stats.drain_eta = _eta(stats.size,
+            stats.service_rate - stats.arrival_rate);
+        return stats;
+    }
+
+    std::chrono::duration<double> time_to_overflow() {
+        return stats().time_to_overflow;
+    }
+
+    std::chrono::duration<double> drain_eta() {
+        return stats().drain_eta;
+    }
+
+    // CoDel active queue management: once the head's sojourn time has
+    // stayed above `target` for a whole `interval`, front pops start
+    // dropping heads at a rate that grows with the square root of the drop
+    // count until the delay recovers. A zero target turns it off.
+    void set_aqm(std::chrono::duration<double> target,
+        std::chrono::duration<double> interval = 100ms) {
+        lock_guard lock(_mutex);
+        _aqm_target = std::chrono::duration_cast<clock::duration>(target);
+        _aqm_interval = std::chrono::duration_cast<clock::duration>(interval);
+        _aqm_first_above = {};
+        _aqm_dropping = false;
+        _aqm_count = 0;
+        _aqm_last_count = 0;
+        _update_stamped();
+    }
+
+    // push_back() first offers the value to `combiner(back, value)` under
+    // the lock; when it returns true the value has been merged into the
+    // current back element and no new slot is used. An empty function turns
+    // combining off.
+    void set_combiner(std::function<bool(T&, const T&)> combiner) {
+        lock_guard lock(_mutex);
+        _combiner = std::move(combiner);
+    }
+
+    // Records the enqueue time of every element, as AQM and age-based LIFO
+    // do implicitly, so front_time() and pop_front_timed() can report it.
+    void set_timestamps(bool enabled) {
+        lock_guard lock(_mutex);
+        _timestamps = enabled;
+        _update_stamped();
+    }
+
+    // Rings `signal` with `id` whenever the head element may have changed.
+    void set_signal(std::shared_ptr<RingSignal> signal, size_t id = 0) {
+        {
+            lock_guard lock(_mutex);
+            _signal = std::move(signal);
+            _signal_id = id;
+        }
+        _signal_head();
+    }
+
+    std::optional<clock::time_point> front_time() {
+        lock_guard lock(_mutex);
+        if (deque::empty() || !_stamped)
+            return std::nullopt;
+        return _stamps.front();
+    }
+
+    std::optional<std::pair<clock::time_point, T>> pop_front_timed() {
+        lock_guard lock(_mutex);
+        if (deque::empty())
+            return std::nullopt;
+        clock::time_point stamp{};
+        T value = _take_front(&stamp);
+        return std::pair<clock::time_point, T>(stamp, std::move(value));
+    }
+
+    // pop_next*() serves FIFO until the ring holds `occupancy` elements or
+    // has not been empty for `busy_age`, then serves newest first until it
+    // holds at most half of `occupancy` (at least one) and has been empty
+    // within half of `busy_age`. The age runs from the first push into an
+    // empty ring rather than from the head, which LIFO never serves, so an
+    // age-triggered LIFO lasts until the ring drains. An occupancy below 2
+    // acts as 2. Zero disables a threshold.
+    void set_adaptive_lifo(size_t occupancy,
+        std::chrono::duration<double> busy_age = 0s) {
+        lock_guard lock(_mutex);
+        _lifo_occupancy = occupancy;
+        _lifo_age = std::chrono::duration_cast<clock::duration>(busy_age);
+        _lifo = false;
+        _update_stamped();
+    }
+
+    std::optional<T> pop_next() {
+        lock_guard lock(_mutex);
+        if (deque::empty())
+            return std::nullopt;
+        return _take_next();
+    }
+
+    std::optional<T> pop_next_wait_for(
+        std::chrono::duration<double> duration = 100ms) {
+        unique_lock lock(_mutex);
+        if (!_cv.wait_for(lock, duration, [&] {
+            return !deque::empty() || _closed;
+        })) {
+            return std::nullopt;
+        }
+        if (deque::empty())
+            return std::nullopt;
+        return _take_next();
+    }
+
+    std::optional<T> pop_next_wait(
+        const std::stop_token& token) {
+        std::stop_callback wake(token, [this] { _wake_all(); });
+        unique_lock lock(_mutex);
+        _cv.wait(lock, [&] {
+            return !deque::empty() || _closed ||
+                token.stop_requested();
+        });
+        if (deque::empty())
+            return std::nullopt;
+        return _take_next();
+    }
+
     void swap(Ring& that) {
         if (this == &that) return;
         std::scoped_lock lock(_mutex, that._mutex);
         std::deque<T>::swap(that);
+        _stamps.swap(that._stamps);
+        _restamp();
+        that._restamp();
+        for (auto ring : {this, &that})
+            if (ring->_signal)
+                ring->_signal->notify(ring->_signal_id);
     }
 
     template <class I>
     void assign(I first, I last) {
-        lock_guard lock(_mutex);
-        deque::assign(first, last);
-        if (auto size = deque::size();
-            size > _capacity)
-            _capacity = size;
+        deque trash(first, last, deque::get_allocator());
+        {
+            lock_guard lock(_mutex);
+            deque::swap(trash);
+            _stamps.clear();
+            _restamp();
+            if (auto size = deque::size();
+                size > _capacity)
+                _capacity = size;
+        }
+        _cv.notify_all();
+        _signal_head();
     }
 
     Ring& operator=(const Ring& that) {
         if (this == &that) return *this;
         std::scoped_lock lock(_mutex, that._mutex);
         std::deque<T>::operator=(that);
+        _stamps.clear();
+        _restamp();
         return *this;
     }
 
     void clear() {
-        deque::clear();
+        deque trash(deque::get_allocator());
+        {
+            lock_guard lock(_mutex);
+            deque::swap(trash);
+            _stamps.clear();
+            _busy_since = {};
+        }
         _cv.notify_one();
     }
 
@@ -263,10 +850,428 @@ public:
     template <class... Args> void emplace(const_iterator, Args&&...) = delete;
     template <class... Args> void insert(const_iterator, Args&&...) = delete;
 
-private:
+protected:
+    template <class... Args>
+    void _admit_front(Args&&... args) {
+        deque::emplace_front(std::forward<Args>(args)...);
+        if (_stamped)
+            _stamps.push_front(clock::now());
+        if (deque::size() > _capacity) {
+            _drop_back();
+            _bump(_evicted);
+        }
+        _bump(_pushed);
+        if (_signal)
+            _signal->notify(_signal_id);
+    }
+
+    template <class... Args>
+    void _admit_back(Args&&... args) {
+        deque::emplace_back(std::forward<Args>(args)...);
+        if (_stamped)
+            _stamps.push_back(clock::now());
+        auto head_changed = deque::size() == 1;
+        if (deque::size() > _capacity) {
+            _drop_front();
+            _bump(_evicted);
+            head_changed = true;
+        }
+        _bump(_pushed);
+        if (_signal && head_changed)
+            _signal->notify(_signal_id);
+    }
+
+    T _take_front(clock::time_point* stamp = nullptr) {
+        if (_aqm_target > clock::duration::zero())
+            _aqm();
+        if (stamp && _stamped)
+            *stamp = _stamps.front();
+        T value = std::move(deque::front());
+        _drop_front();
+        _bump(_popped);
+        return value;
+    }
+
+    T _take_back() {
+        T value = std::move(deque::back());
+        _drop_back();
+        _bump(_popped);
+        return value;
+    }
+
+    T _take_next() {
+        if (_lifo_occupancy || _lifo_age > clock::duration::zero()) {
+            auto size = deque::size();
+            if (_stamped && _busy_since == clock::time_point{})
+                _busy_since = _stamps.front();
+            auto age = _stamped ? clock::now() - _busy_since
+                                : clock::duration::zero();
+            auto high = std::max<size_t>(_lifo_occupancy, 2);
+            auto low = std::max<size_t>(_lifo_occupancy / 2, 1);
+            auto over = [&](bool entering) {
+                auto size_limit = entering ? high : low + 1;
+                auto age_limit = entering ? _lifo_age : _lifo_age / 2;
+                return (_lifo_occupancy && size >= size_limit) ||
+                    (_lifo_age > clock::duration::zero() &&
+                        age >= age_limit);
+            };
+            if (_lifo != over(!_lifo)) {
+                _lifo = !_lifo;
+                ++_lifo_switches;
+            }
+        }
+        return _lifo ? _take_back() : _take_front();
+    }
+
+    bool _combine_back(const T& value) {
+        if (!_combiner || deque::empty() ||
+            !_combiner(deque::back(), value))
+            return false;
+        ++_combined;
+        return true;
+    }
+
+    void _drop_front() {
+        deque::pop_front();
+        if (_stamped)
+            _stamps.pop_front();
+        if (deque::empty())
+            _busy_since = {};
+    }
+
+    void _drop_back() {
+        deque::pop_back();
+        if (_stamped)
+            _stamps.pop_back();
+        if (deque::empty())
+            _busy_since = {};
+    }
+
+    void _update_stamped() {
+        _stamped = _timestamps || _aqm_target > clock::duration::zero() ||
+            _lifo_age > clock::duration::zero();
+        _restamp();
+    }
+
+    void _signal_head() {
+        std::shared_ptr<RingSignal> signal;
+        size_t id;
+        {
+            lock_guard lock(_mutex);
+            signal = _signal;
+            id = _signal_id;
+        }
+        if (signal)
+            signal->notify(id);
+    }
+
+    // Brings _stamps back in line with the elements after a bulk change;
+    // elements of unknown age count as enqueued now.
+    void _restamp() {
+        _busy_since = {};
+        if (!_stamped)
+            _stamps.clear();
+        else if (_stamps.size() != deque::size())
+            _stamps.assign(deque::size(), clock::now());
+    }
+
+    // RFC 8289 dequeue logic, applied to the head before it is taken. The
+    // last element is never dropped, so a non-empty ring stays non-empty.
+    void _aqm() {
+        auto now = clock::now();
+        auto ok_to_drop = _aqm_ok_to_drop(now);
+        if (_aqm_dropping) {
+            if (!ok_to_drop) {
+                _aqm_dropping = false;
+                return;
+            }
+            while (now >= _aqm_drop_next && _aqm_dropping) {
+                _aqm_drop();
+                ++_aqm_count;
+                if (!_aqm_ok_to_drop(now))
+                    _aqm_dropping = false;
+                else
+                    _aqm_drop_next = _aqm_control(_aqm_drop_next);
+            }
+        } else if (ok_to_drop) {
+            _aqm_drop();
+            _aqm_ok_to_drop(now);
+            _aqm_dropping = true;
+            auto delta = _aqm_count - _aqm_last_count;
+            _aqm_count = delta > 1 &&
+                now - _aqm_drop_next < 16 * _aqm_interval ? delta : 1;
+            _aqm_drop_next = _aqm_control(now);
+            _aqm_last_count = _aqm_count;
+        }
+    }
+
+    bool _aqm_ok_to_drop(clock::time_point now) {
+        if (deque::size() <= 1 || now - _stamps.front() < _aqm_target) {
+            _aqm_first_above = {};
+            return false;
+        }
+        if (_aqm_first_above == clock::time_point{}) {
+            _aqm_first_above = now + _aqm_interval;
+            return false;
+        }
+        return now >= _aqm_first_above;
+    }
+
+    void _aqm_drop() {
+        _drop_front();
+        _dropped.store(_dropped.load(std::memory_order_relaxed) + 1,
+            std::memory_order_relaxed);
+    }
+
+    clock::time_point _aqm_control(clock::time_point t) const {
+        return t + std::chrono::duration_cast<clock::duration>(
+            _aqm_interval / std::sqrt(static_cast<double>(_aqm_count)));
+    }
+
+    // Counters are only written under _mutex, so a relaxed load/store pair
+    // is enough and avoids a locked RMW on every push and pop. The EWMAs are
+    // refolded every 64 events rather than reading the clock each time.
+    void _bump(std::atomic<uint64_t>& counter) {
+        auto value = counter.load(std::memory_order_relaxed) + 1;
+        counter.store(value, std::memory_order_relaxed);
+        if (!(value & 63))
+            _sample(clock::now());
+    }
+
+    void _sample(clock::time_point now) {
+        std::chrono::duration<double> elapsed = now - _sampled_at;
+        if (elapsed < 1ms)
+            return;
+        auto pushed = _pushed.load(std::memory_order_relaxed);
+        auto popped = _popped.load(std::memory_order_relaxed);
+        auto alpha = 1.0 - std::exp(-elapsed / _rate_window);
+        auto fold = [&](std::atomic<double>& rate, uint64_t events) {
+            auto current = rate.load(std::memory_order_relaxed);
+            rate.store(current + alpha * (events / elapsed.count() - current),
+                std::memory_order_relaxed);
+        };
+        fold(_arrival_rate, pushed - _sampled_pushed);
+        fold(_service_rate, popped - _sampled_popped);
+        _sampled_pushed = pushed;
+        _sampled_popped = popped;
+        _sampled_at = now;
+    }
+
+    static std::chrono::duration<double> _eta(double room, double rate) {
+        if (rate <= 0)
+            return std::chrono::duration<double>(
+                std::numeric_limits<double>::infinity());
+        return std::chrono::duration<double>(room / rate);
+    }
+
+    void _wake_all() {
+        { lock_guard lock(_mutex); }
+        _cv.notify_all();
+        _pace_cv.notify_all();
+    }
+
+    // Waits for a non-empty ring and at least one whole token; returns the
+    // number of whole tokens, 0 on stop. Token sleeps use their own condition
+    // variable so they never swallow a push notification meant for another
+    // consumer.
+    size_t _pace_wait(unique_lock& lock, double rate, double burst,
+        const std::stop_token& token) {
+        burst = std::max(burst, 1.0);
+        for (;;) {
+            if (token.stop_requested() || (_closed && deque::empty()))
+                return 0;
+            auto now = clock::now();
+            if (rate > 0) {
+                std::chrono::duration<double> elapsed = now - _pace_at;
+                _pace_tokens = std::min(burst,
+                    _pace_tokens + elapsed.count() * rate);
+            }
+            _pace_at = now;
+            if (deque::empty()) {
+                _cv.wait(lock, [&] {
+                    return !deque::empty() || _closed ||
+                        token.stop_requested();
+                });
+            } else if (_pace_tokens < 1) {
+                if (rate <= 0) {
+                    if (_closed)
+                        return 0; /* no token is ever coming */
+                    _pace_cv.wait(lock, [&] {
+                        return _closed || token.stop_requested();
+                    });
+                } else {
+                    _pace_cv.wait_until(lock, now +
+                        std::chrono::duration_cast<clock::duration>(
+                            std::chrono::duration<double>(
+                                (1 - _pace_tokens) / rate)));
+                }
+            } else {
+                return static_cast<size_t>(_pace_tokens);
+            }
+        }
+    }
+
+    template <class OutputIt>
+    size_t _take_front_n(OutputIt out, size_t n) {
+        size_t count = 0;
+        for (; count < n && !deque::empty(); ++count)
+            *out++ = _take_front();
+        return count;
+    }
+
+    // Pins the calling thread; returns 0 or an errno value.
+    static int _pin(int cpu) {
+#if defined(__linux__)
+        if (cpu < 0 || cpu >= CPU_SETSIZE)
+            return EINVAL;
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        return pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#else
+        (void)cpu;
+        return ENOTSUP;
+#endif
+    }
+
+    template <class F>
+    void _consume(const std::stop_token& token, F& fn,
+        const ConsumerOptions& options, RingConsumer::Counters& counters) {
+        std::vector<T> batch;
+        auto limit = options.batch ? options.batch : 1;
+        batch.reserve(limit);
+        while (!token.stop_requested()) {
+            batch.clear();
+            if (options.wait != WaitStrategy::block) {
+                for (size_t i = 0; i < options.spin && batch.empty(); ++i) {
+                    if (pop_front_n(std::back_inserter(batch), limit))
+                        break;
+                    if (options.wait == WaitStrategy::yield)
+                        std::this_thread::yield();
+                    if (token.stop_requested())
+                        return;
+                }
+            }
+            if (batch.empty()) {
+                counters.waits.fetch_add(1, std::memory_order_relaxed);
+                if (!pop_front_wait_n(std::back_inserter(batch), limit, token)) {
+                    if (closed())
+                        return;
+                    continue;
+                }
+            }
+            if constexpr (std::is_invocable_v<F&, std::span<T>>) {
+                fn(std::span<T>(batch));
+            } else {
+                for (auto& value : batch)
+                    fn(std::move(value));
+            }
+            counters.items.fetch_add(batch.size(), std::memory_order_relaxed);
+            counters.batches.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    // Slides the elements `pred` rejects, and their stamps, towards the
+    // front and returns how many there are; the tail is left for
+    // _truncate(). Trivially copyable elements are copied unconditionally
+    // and the write cursor advanced by the verdict, so the loop has no
+    // data-dependent branch to mispredict. If `pred` throws, the unread
+    // rest is slid down after the kept ones and the exception is handed
+    // back in `failure`, so the caller can still truncate.
+    template <class Pred>
+    size_t _compact(Pred& pred, std::exception_ptr& failure) {
+        auto write = deque::begin();
+        auto read = deque::begin();
+        auto stamp = _stamps.begin();
+        auto read_stamp = _stamps.begin();
+        try {
+            for (; read != deque::end(); ++read) {
+                bool keep = !pred(std::as_const(*read));
+                if constexpr (std::is_trivially_copyable_v<T>) {
+                    *write = *read;
+                    write += keep;
+                } else if (keep) {
+                    if (write != read)
+                        *write = std::move(*read);
+                    ++write;
+                }
+                if (_stamped) {
+                    *stamp = *read_stamp++;
+                    stamp += keep;
+                }
+            }
+        } catch (...) {
+            failure = std::current_exception();
+            if (write == read)
+                return deque::size();
+            write = std::move(read, deque::end(), write);
+            if (_stamped)
+                std::copy(read_stamp, _stamps.end(), stamp);
+        }
+        return static_cast<size_t>(write - deque::begin());
+    }
+
+    // Drops everything past `size`; the dropped elements are destroyed with
+    // `trash`, after the caller releases the lock. Under the lock, whichever
+    // side is shorter is moved: either the dropped tail into `trash`, or,
+    // after swapping everything into `trash`, the kept prefix back. So the
+    // lock is held for O(min(kept, dropped)) moves, not O(1).
+    void _truncate(size_t size, deque& trash) {
+        if (_stamped)
+            _stamps.resize(size);
+        if (size == 0) {
+            _busy_since = {};
+            deque::swap(trash);
+        } else if constexpr (std::is_trivially_destructible_v<T>) {
+            deque::resize(size);
+        } else if (size <= deque::size() - size) {
+            deque::swap(trash);
+            deque::assign(std::make_move_iterator(trash.begin()),
+                          std::make_move_iterator(trash.begin() + size));
+        } else {
+            auto first = deque::begin() + size;
+            trash.assign(std::make_move_iterator(first),
+                         std::make_move_iterator(deque::end()));
+            deque::erase(first, deque::end());
+        }
+    }
+
     size_t _capacity;
     std::mutex _mutex;
     std::condition_variable _cv;
+    std::condition_variable _pace_cv;
+    bool _closed = false;
+    double _pace_tokens = 0;
+    clock::time_point _pace_at{};
+    std::atomic<uint64_t> _pushed{0};
+    std::atomic<uint64_t> _popped{0};
+    std::atomic<uint64_t> _evicted{0};
+    std::atomic<double> _arrival_rate{0};
+    std::atomic<double> _service_rate{0};
+    std::chrono::duration<double> _rate_window = 1s;
+    clock::time_point _sampled_at = clock::now();
+    uint64_t _sampled_pushed = 0;
+    uint64_t _sampled_popped = 0;
+    std::atomic<uint64_t> _dropped{0};
+    bool _stamped = false;
+    std::deque<clock::time_point> _stamps;
+    clock::duration _aqm_target{};
+    clock::duration _aqm_interval{};
+    clock::time_point _aqm_first_above{};
+    clock::time_point _aqm_drop_next{};
+    uint64_t _aqm_count = 0;
+    uint64_t _aqm_last_count = 0;
+    bool _aqm_dropping = false;
+    size_t _lifo_occupancy = 0;
+    clock::duration _lifo_age{};
+    bool _lifo = false;
+    uint64_t _lifo_switches = 0;
+    clock::time_point _busy_since{}; /* first push since last empty */
+    std::function<bool(T&, const T&)> _combiner;
+    bool _timestamps = false;
+    std::shared_ptr<RingSignal> _signal;
+    size_t _signal_id = 0;
+    uint64_t _combined = 0;
 };
 
 // deduction guide
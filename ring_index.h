@@ -0,0 +1,65 @@
+#pragma once
+#include <bit> /* bit_ceil has_single_bit */
+#include <cstddef> /* size_t */
+#include <cstdint> /* uint64_t */
+
+// Maps a running sequence number onto a slot array. With `pow2` the slot
+// count is rounded up to a power of two so the wrap is a single AND; the
+// logical capacity the owner enforces stays what was asked for.
+class RingIndex {
+public:
+    // The two mappings, each without a branch. Loops get one of them from
+    // visit(), so the mode is tested once per call instead of per index.
+    struct Masked {
+        size_t mask;
+
+        size_t operator()(uint64_t sequence) const noexcept {
+            return sequence & mask;
+        }
+    };
+
+    struct Modulo {
+        size_t slots;
+
+        size_t operator()(uint64_t sequence) const noexcept {
+            return sequence % slots;
+        }
+    };
+
+    RingIndex(size_t capacity, bool pow2 = false)
+        : _capacity(capacity ? capacity : 1),
+          _slots(pow2 ? std::bit_ceil(_capacity) : _capacity),
+          _mask(std::has_single_bit(_slots) ? _slots - 1 : 0) {}
+
+    size_t capacity() const noexcept {
+        return _capacity;
+    }
+
+    size_t slots() const noexcept {
+        return _slots;
+    }
+
+    bool masked() const noexcept {
+        return _mask || _slots == 1;
+    }
+
+    // Calls `fn` with the Masked or Modulo mapping.
+    template <class F>
+    decltype(auto) visit(F&& fn) const {
+        if (masked())
+            return fn(Masked{_mask});
+        return fn(Modulo{_slots});
+    }
+
+    // For a single lookup; the branch is the same on every call.
+    size_t operator()(uint64_t sequence) const noexcept {
+        if (masked())
+            return sequence & _mask;
+        return sequence % _slots;
+    }
+
+private:
+    size_t _capacity;
+    size_t _slots;
+    size_t _mask;
+};
@@ -0,0 +1,451 @@
+#pragma once
+#include "ring.h"
+#include <cerrno> /* errno EINTR EAGAIN */
+#include <cstring> /* memcpy memmove memset */
+#include <fcntl.h> /* fcntl O_NONBLOCK */
+#include <sys/socket.h> /* sendmsg MSG_DONTWAIT */
+#include <sys/stat.h> /* fstat S_ISFIFO S_ISSOCK */
+#include <new> /* align_val_t */
+#include <poll.h> /* poll */
+#include <sys/uio.h> /* writev iovec */
+#include <climits> /* IOV_MAX PIPE_BUF */
+#include <unistd.h> /* read write */
+
+struct RingIoOptions {
+    size_t max_batch = 64; /* elements per drain */
+    std::chrono::duration<double> linger{}; /* wait to fill a batch */
+    size_t align = 0; /* O_DIRECT block size, 0 - unaligned I/O */
+    size_t buffer = 64 * 1024; /* RingSource read size */
+    bool close_on_eof = false; /* RingSource closes the ring at EOF */
+};
+
+struct RingIoStats {
+    uint64_t items = 0;
+    uint64_t bytes = 0;
+    uint64_t calls = 0; /* read/write system calls */
+};
+
+namespace ring_io {
+
+// Buffer whose start and size are multiples of the O_DIRECT block size.
+class AlignedBuffer {
+public:
+    AlignedBuffer(size_t align = 0) : _align(align ? align : 1) {}
+
+    AlignedBuffer(AlignedBuffer&&) = delete;
+
+    ~AlignedBuffer() {
+        if (_data)
+            ::operator delete(_data, std::align_val_t(_align));
+    }
+
+    char* data() noexcept {
+        return _data;
+    }
+
+    size_t capacity() const noexcept {
+        return _capacity;
+    }
+
+    // Keeps the first `keep` bytes.
+    void reserve(size_t size, size_t keep) {
+        if (size <= _capacity)
+            return;
+        size = (size + _align - 1) / _align * _align;
+        auto data = static_cast<char*>(
+            ::operator new(size, std::align_val_t(_align)));
+        if (keep)
+            std::memcpy(data, _data, keep);
+        if (_data)
+            ::operator delete(_data, std::align_val_t(_align));
+        _data = data;
+        _capacity = size;
+    }
+
+private:
+    size_t _align;
+    char* _data = nullptr;
+    size_t _capacity = 0;
+};
+
+} // namespace ring_io
+
+// Drains a ring into a file descriptor on its own thread. Each round takes
+// up to max_batch elements under one lock, optionally lingers for the rest
+// of the batch, and hands the serialized views of all of them to writev().
+// The serializer returns a view into the element, which stays alive until
+// the write is done. With `align` the bytes are staged in an aligned buffer
+// and written in whole blocks, and the final partial block is zero-padded
+// when the sink stops. The descriptor's flags are left alone: sockets are
+// written with MSG_DONTWAIT, and a blocking pipe is polled before each
+// write of at most PIPE_BUF bytes, which then cannot block. A full pipe or
+// socket is polled in 100ms steps, so a stop request is seen even when the
+// reader stalls. The sink then gives up with error() ECANCELED: the batch
+// being written is dropped, the rest stays queued. Other descriptors, such
+// as regular files, are written as they are.
+template<class T, class Allocator = std::allocator<T>>
+class RingSink {
+public:
+    using ring = Ring<T, Allocator>;
+    using clock = typename ring::clock;
+    using Serializer = std::function<std::span<const char>(const T&)>;
+
+    RingSink(ring& source, int fd, Serializer serializer,
+        RingIoOptions options = {})
+        : _ring(&source), _fd(fd), _serializer(std::move(serializer)),
+          _options(options), _staging(options.align) {
+        if (!_options.max_batch)
+            _options.max_batch = 1;
+        _thread = std::jthread([this](std::stop_token token) {
+            _run(token);
+        });
+    }
+
+    // Flushes what is still queued, then joins.
+    ~RingSink() {
+        request_stop();
+        join();
+    }
+
+    RingSink(const RingSink&) = delete;
+    RingSink& operator=(const RingSink&) = delete;
+
+    void request_stop() noexcept {
+        _thread.request_stop();
+    }
+
+    // Only waits: the sink finishes once the ring is closed and drained,
+    // or after request_stop().
+    void join() {
+        if (_thread.joinable())
+            _thread.join();
+    }
+
+    // errno of the write that failed and stopped the sink, ECANCELED if it
+    // was stopped while the descriptor would not take more, 0 if neither.
+    int error() const noexcept {
+        return _error.load(std::memory_order_acquire);
+    }
+
+    RingIoStats stats() const noexcept {
+        return {_items.load(std::memory_order_relaxed),
+            _bytes.load(std::memory_order_relaxed),
+            _calls.load(std::memory_order_relaxed)};
+    }
+
+private:
+    void _run(const std::stop_token& token) {
+        struct stat status;
+        if (::fstat(_fd, &status) == 0) {
+            auto flags = ::fcntl(_fd, F_GETFL);
+            _socket = S_ISSOCK(status.st_mode);
+            _pipe = S_ISFIFO(status.st_mode) && flags >= 0 &&
+                !(flags & O_NONBLOCK);
+        }
+        std::vector<T> batch;
+        batch.reserve(_options.max_batch);
+        while (!error()) {
+            batch.clear();
+            if (!_ring->pop_front_wait_n(std::back_inserter(batch),
+                    _options.max_batch, token)) {
+                if (token.stop_requested() || _ring->closed())
+                    break;
+                continue;
+            }
+            _linger(batch, token);
+            _write(batch, token);
+        }
+        while (!error()) {
+            batch.clear();
+            if (!_ring->pop_front_n(std::back_inserter(batch),
+                    _options.max_batch))
+                break;
+            _write(batch, token);
+        }
+        if (_options.align && _staged && !error()) {
+            auto padded = (_staged + _options.align - 1) /
+                _options.align * _options.align;
+            std::memset(_staging.data() + _staged, 0, padded - _staged);
+            _staged = padded;
+            _flush(token);
+        }
+    }
+
+    void _linger(std::vector<T>& batch, const std::stop_token& token) {
+        if (_options.linger <= std::chrono::duration<double>::zero())
+            return;
+        auto deadline = clock::now() +
+            std::chrono::duration_cast<typename clock::duration>(
+                _options.linger);
+        while (batch.size() < _options.max_batch &&
+               !token.stop_requested()) {
+            auto left = deadline - clock::now();
+            if (left <= clock::duration::zero())
+                break;
+            auto value = _ring->pop_front_wait_for(left);
+            if (!value)
+                break;
+            batch.push_back(std::move(*value));
+            _ring->pop_front_n(std::back_inserter(batch),
+                _options.max_batch - batch.size());
+        }
+    }
+
+    void _write(const std::vector<T>& batch, const std::stop_token& token) {
+        size_t bytes = 0;
+        _iov.clear();
+        for (auto& value : batch) {
+            auto view = _serializer(value);
+            if (view.empty())
+                continue;
+            _iov.push_back({const_cast<char*>(view.data()), view.size()});
+            bytes += view.size();
+        }
+        if (_options.align) {
+            _staging.reserve(_staged + bytes, _staged);
+            for (auto& iov : _iov) {
+                std::memcpy(_staging.data() + _staged, iov.iov_base,
+                    iov.iov_len);
+                _staged += iov.iov_len;
+            }
+            _flush(token);
+        } else {
+            _writev(_iov.data(), _iov.size(), token);
+        }
+        if (!error()) {
+            _items.fetch_add(batch.size(), std::memory_order_relaxed);
+            _bytes.fetch_add(bytes, std::memory_order_relaxed);
+        }
+    }
+
+    // Writes the whole blocks of the staging buffer and keeps the rest.
+    void _flush(const std::stop_token& token) {
+        auto whole = _staged / _options.align * _options.align;
+        if (!whole)
+            return;
+        iovec iov{_staging.data(), whole};
+        _writev(&iov, 1, token);
+        std::memmove(_staging.data(), _staging.data() + whole,
+            _staged - whole);
+        _staged -= whole;
+    }
+
+    void _writev(iovec* iov, size_t count, const std::stop_token& token) {
+        while (count) {
+            auto chunk = count < IOV_MAX ? count : IOV_MAX;
+            ssize_t written;
+            if (_pipe) {
+                if (!_writable(token)) {
+                    if (!error())
+                        _error.store(ECANCELED, std::memory_order_release);
+                    return;
+                }
+                written = _write_pipe(iov, chunk);
+            } else if (_socket) {
+                msghdr message{};
+                message.msg_iov = iov;
+                message.msg_iovlen = chunk;
+                written = ::sendmsg(_fd, &message, MSG_DONTWAIT);
+            } else {
+                written = ::writev(_fd, iov, static_cast<int>(chunk));
+            }
+            _calls.fetch_add(1, std::memory_order_relaxed);
+            if (written < 0) {
+                if (errno == EINTR)
+                    continue;
+                if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                    if (_writable(token))
+                        continue;
+                    if (!error())
+                        _error.store(ECANCELED, std::memory_order_release);
+                    return;
+                }
+                _error.store(errno, std::memory_order_release);
+                return;
+            }
+            auto left = static_cast<size_t>(written);
+            while (count && left >= iov->iov_len) {
+                left -= iov->iov_len;
+                ++iov;
+                --count;
+            }
+            if (count) {
+                iov->iov_base = static_cast<char*>(iov->iov_base) + left;
+                iov->iov_len -= left;
+            }
+        }
+    }
+
+    // A blocking pipe that polled writable has room for PIPE_BUF bytes, so
+    // writing no more than that returns without waiting.
+    ssize_t _write_pipe(iovec* iov, size_t count) {
+        size_t bytes = 0, n = 0;
+        for (; n < count && bytes + iov[n].iov_len <= PIPE_BUF; ++n)
+            bytes += iov[n].iov_len;
+        if (n)
+            return ::writev(_fd, iov, static_cast<int>(n));
+        return ::write(_fd, iov->iov_base, PIPE_BUF);
+    }
+
+    // Waits for room in 100ms steps; false once a stop is requested. When
+    // already stopping, the final drain gets one step before giving up.
+    bool _writable(const std::stop_token& token) {
+        for (;;) {
+            pollfd wait{_fd, POLLOUT, 0};
+            auto ready = ::poll(&wait, 1, 100);
+            if (ready > 0)
+                return true;
+            if (ready < 0 && errno != EINTR) {
+                _error.store(errno, std::memory_order_release);
+                return false;
+            }
+            if (token.stop_requested())
+                return false;
+        }
+    }
+
+    ring* _ring;
+    int _fd;
+    Serializer _serializer;
+    RingIoOptions _options;
+    std::vector<iovec> _iov;
+    ring_io::AlignedBuffer _staging;
+    size_t _staged = 0;
+    bool _socket = false;
+    bool _pipe = false; /* blocking pipe or FIFO */
+    std::atomic<int> _error{0};
+    std::atomic<uint64_t> _items{0};
+    std::atomic<uint64_t> _bytes{0};
+    std::atomic<uint64_t> _calls{0};
+    std::jthread _thread;
+};
+
+// Fills a ring from a file descriptor on its own thread. Reads of up to
+// `buffer` bytes are handed to the deserializer, which appends every whole
+// element it finds and returns how many bytes it used; the remainder is
+// carried into the next read. The thread stops at end of file, on a read
+// error or when asked to; the descriptor is polled so a stop request is
+// seen within 100ms even on an idle pipe or socket. With `align` every
+// read goes to an aligned buffer of whole blocks first.
+template<class T, class Allocator = std::allocator<T>>
+class RingSource {
+public:
+    using ring = Ring<T, Allocator>;
+    using Deserializer =
+        std::function<size_t(std::span<const char>, std::vector<T>&)>;
+
+    RingSource(ring& target, int fd, Deserializer deserializer,
+        RingIoOptions options = {})
+        : _ring(&target), _fd(fd), _deserializer(std::move(deserializer)),
+          _options(options), _block(options.align) {
+        if (!_options.buffer)
+            _options.buffer = 1;
+        _thread = std::jthread([this](std::stop_token token) {
+            _run(token);
+        });
+    }
+
+    ~RingSource() {
+        request_stop();
+        join();
+    }
+
+    RingSource(const RingSource&) = delete;
+    RingSource& operator=(const RingSource&) = delete;
+
+    void request_stop() noexcept {
+        _thread.request_stop();
+    }
+
+    // Only waits: the source finishes at end of file, on a read error or
+    // after request_stop().
+    void join() {
+        if (_thread.joinable())
+            _thread.join();
+    }
+
+    bool eof() const noexcept {
+        return _eof.load(std::memory_order_acquire);
+    }
+
+    int error() const noexcept {
+        return _error.load(std::memory_order_acquire);
+    }
+
+    RingIoStats stats() const noexcept {
+        return {_items.load(std::memory_order_relaxed),
+            _bytes.load(std::memory_order_relaxed),
+            _calls.load(std::memory_order_relaxed)};
+    }
+
+private:
+    void _run(const std::stop_token& token) {
+        std::vector<char> pending;
+        std::vector<T> batch;
+        if (_options.align)
+            _block.reserve(_options.buffer, 0);
+        while (!token.stop_requested()) {
+            pollfd wait{_fd, POLLIN, 0};
+            auto ready = ::poll(&wait, 1, 100);
+            if (ready < 0 && errno != EINTR) {
+                _error.store(errno, std::memory_order_release);
+                break;
+            }
+            if (ready <= 0)
+                continue;
+            auto used = pending.size();
+            char* target;
+            size_t size;
+            if (_options.align) {
+                target = _block.data();
+                size = _block.capacity();
+            } else {
+                pending.resize(used + _options.buffer);
+                target = pending.data() + used;
+                size = _options.buffer;
+            }
+            auto got = ::read(_fd, target, size);
+            _calls.fetch_add(1, std::memory_order_relaxed);
+            if (got < 0) {
+                pending.resize(used);
+                if (errno == EINTR || errno == EAGAIN ||
+                    errno == EWOULDBLOCK)
+                    continue;
+                _error.store(errno, std::memory_order_release);
+                break;
+            }
+            if (got == 0) {
+                _eof.store(true, std::memory_order_release);
+                break;
+            }
+            if (_options.align)
+                pending.insert(pending.end(), target, target + got);
+            else
+                pending.resize(used + static_cast<size_t>(got));
+            _bytes.fetch_add(static_cast<size_t>(got),
+                std::memory_order_relaxed);
+            batch.clear();
+            auto consumed = _deserializer(
+                std::span<const char>(pending), batch);
+            pending.erase(pending.begin(), pending.begin() +
+                static_cast<std::ptrdiff_t>(consumed));
+            _ring->push_back_n(std::make_move_iterator(batch.begin()),
+                std::make_move_iterator(batch.end()));
+            _items.fetch_add(batch.size(), std::memory_order_relaxed);
+        }
+        if (_options.close_on_eof && eof())
+            _ring->close();
+    }
+
+    ring* _ring;
+    int _fd;
+    Deserializer _deserializer;
+    RingIoOptions _options;
+    ring_io::AlignedBuffer _block;
+    std::atomic<bool> _eof{false};
+    std::atomic<int> _error{0};
+    std::atomic<uint64_t> _items{0};
+    std::atomic<uint64_t> _bytes{0};
+    std::atomic<uint64_t> _calls{0};
+    std::jthread _thread;
+};
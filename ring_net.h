@@ -0,0 +1,357 @@
+#pragma once
+#include "ring_io.h"
+#include <sys/socket.h> /* recvmmsg sendmmsg mmsghdr sockaddr_storage */
+
+namespace ring_net {
+
+// Leaves new elements default-initialised, so growing a receive buffer does
+// not zero the bytes the kernel is about to overwrite.
+template<class T>
+struct UninitializedAllocator : std::allocator<T> {
+    template<class U>
+    struct rebind {
+        using other = UninitializedAllocator<U>;
+    };
+
+    UninitializedAllocator() = default;
+
+    template<class U>
+    UninitializedAllocator(const UninitializedAllocator<U>&) noexcept {}
+
+    template<class U>
+    void construct(U* p) {
+        ::new (static_cast<void*>(p)) U;
+    }
+
+    template<class U, class... Args>
+    void construct(U* p, Args&&... args) {
+        ::new (static_cast<void*>(p)) U(std::forward<Args>(args)...);
+    }
+};
+
+} // namespace ring_net
+
+struct Datagram {
+    using Bytes = std::vector<char, ring_net::UninitializedAllocator<char>>;
+
+    Bytes data;
+    sockaddr_storage address{}; /* source on ingest, destination on egress */
+    socklen_t address_size = 0; /* 0 - the socket's connected peer */
+};
+
+// Spare datagram buffers. UdpEgress returns what it has sent, consumers of
+// a UdpIngest ring return what they are done with, and UdpIngest takes them
+// back instead of allocating. Holds at most `limit` buffers.
+class DatagramPool {
+public:
+    using lock_guard = std::lock_guard<std::mutex>;
+
+    DatagramPool(size_t limit = 4096) : _limit(limit) {}
+
+    DatagramPool(const DatagramPool&) = delete;
+    DatagramPool& operator=(const DatagramPool&) = delete;
+
+    size_t size() {
+        lock_guard lock(_mutex);
+        return _free.size();
+    }
+
+    void release(Datagram&& datagram) {
+        release(&datagram, &datagram + 1);
+    }
+
+    // Keeps the buffers of [first, last) under one lock.
+    template<class I>
+    void release(I first, I last) {
+        lock_guard lock(_mutex);
+        for (; first != last && _free.size() < _limit; ++first) {
+            if (first->data.capacity())
+                _free.push_back(std::move(first->data));
+        }
+    }
+
+    // Appends up to `count` spare buffers to `out`.
+    size_t acquire(std::vector<Datagram::Bytes>& out, size_t count) {
+        lock_guard lock(_mutex);
+        count = std::min(count, _free.size());
+        for (size_t i = 0; i < count; ++i) {
+            out.push_back(std::move(_free.back()));
+            _free.pop_back();
+        }
+        return count;
+    }
+
+private:
+    size_t _limit;
+    std::vector<Datagram::Bytes> _free;
+    std::mutex _mutex;
+};
+
+struct UdpOptions {
+    size_t batch = 64; /* datagrams per system call */
+    size_t size = 2048; /* largest datagram received, longer are cut */
+    DatagramPool* pool = nullptr; /* recycles buffers, nullptr - allocate */
+};
+
+// Receives datagrams from a UDP socket into a ring on its own thread. One
+// recvmmsg() fills up to `batch` Datagram buffers that the adapter owns,
+// and the filled ones are moved into the ring with a single push_back_n(),
+// so a burst costs one system call and one lock. The moved-out buffers are
+// replaced from the options' pool when it has spares, otherwise allocated
+// without being zero-filled. Linux only.
+class UdpIngest {
+public:
+    using ring = Ring<Datagram>;
+
+    UdpIngest(ring& target, int fd, UdpOptions options = {})
+        : _ring(&target), _fd(fd), _options(options) {
+        if (!_options.batch)
+            _options.batch = 1;
+        _thread = std::jthread([this](std::stop_token token) {
+            _run(token);
+        });
+    }
+
+    ~UdpIngest() {
+        request_stop();
+        join();
+    }
+
+    UdpIngest(const UdpIngest&) = delete;
+    UdpIngest& operator=(const UdpIngest&) = delete;
+
+    void request_stop() noexcept {
+        _thread.request_stop();
+    }
+
+    // Only waits: ingest runs until a receive error or request_stop().
+    void join() {
+        if (_thread.joinable())
+            _thread.join();
+    }
+
+    int error() const noexcept {
+        return _error.load(std::memory_order_acquire);
+    }
+
+    RingIoStats stats() const noexcept {
+        return {_items.load(std::memory_order_relaxed),
+            _bytes.load(std::memory_order_relaxed),
+            _calls.load(std::memory_order_relaxed)};
+    }
+
+private:
+    void _run(const std::stop_token& token) {
+        std::vector<Datagram> batch(_options.batch);
+        std::vector<mmsghdr> headers(_options.batch);
+        std::vector<iovec> iov(_options.batch);
+        std::vector<Datagram::Bytes> spare;
+        while (!token.stop_requested()) {
+            for (size_t i = 0; i < batch.size(); ++i) {
+                auto& datagram = batch[i];
+                if (datagram.data.capacity() < _options.size &&
+                    !spare.empty()) {
+                    datagram.data = std::move(spare.back());
+                    spare.pop_back();
+                }
+                datagram.data.resize(_options.size);
+                iov[i] = {datagram.data.data(), datagram.data.size()};
+                headers[i] = {};
+                headers[i].msg_hdr.msg_name = &datagram.address;
+                headers[i].msg_hdr.msg_namelen = sizeof(datagram.address);
+                headers[i].msg_hdr.msg_iov = &iov[i];
+                headers[i].msg_hdr.msg_iovlen = 1;
+            }
+            pollfd wait{_fd, POLLIN, 0};
+            auto ready = ::poll(&wait, 1, 100);
+            if (ready < 0 && errno != EINTR) {
+                _error.store(errno, std::memory_order_release);
+                break;
+            }
+            if (ready <= 0)
+                continue;
+            auto got = ::recvmmsg(_fd, headers.data(),
+                static_cast<unsigned>(headers.size()), MSG_DONTWAIT,
+                nullptr);
+            _calls.fetch_add(1, std::memory_order_relaxed);
+            if (got < 0) {
+                if (errno == EINTR || errno == EAGAIN ||
+                    errno == EWOULDBLOCK)
+                    continue;
+                _error.store(errno, std::memory_order_release);
+                break;
+            }
+            size_t bytes = 0;
+            for (int i = 0; i < got; ++i) {
+                batch[i].data.resize(headers[i].msg_len);
+                batch[i].address_size = headers[i].msg_hdr.msg_namelen;
+                bytes += headers[i].msg_len;
+            }
+            _ring->push_back_n(std::make_move_iterator(batch.begin()),
+                std::make_move_iterator(batch.begin() + got));
+            if (_options.pool)
+                _options.pool->acquire(spare, static_cast<size_t>(got));
+            _items.fetch_add(static_cast<size_t>(got),
+                std::memory_order_relaxed);
+            _bytes.fetch_add(bytes, std::memory_order_relaxed);
+        }
+    }
+
+    ring* _ring;
+    int _fd;
+    UdpOptions _options;
+    std::atomic<int> _error{0};
+    std::atomic<uint64_t> _items{0};
+    std::atomic<uint64_t> _bytes{0};
+    std::atomic<uint64_t> _calls{0};
+    std::jthread _thread;
+};
+
+// Sends a ring's datagrams on a UDP socket from its own thread: up to
+// `batch` are popped under one lock and handed to one sendmmsg(). Those
+// with an address go to it, the rest to the socket's connected peer, and
+// the sent buffers go back to the options' pool if there is one. When
+// stopped it sends what is still queued first. A full socket buffer is
+// polled in 100ms steps, and a stop request seen meanwhile drops the batch
+// with error() ECANCELED. Linux only.
+class UdpEgress {
+public:
+    using ring = Ring<Datagram>;
+
+    UdpEgress(ring& source, int fd, UdpOptions options = {})
+        : _ring(&source), _fd(fd), _options(options) {
+        if (!_options.batch)
+            _options.batch = 1;
+        _thread = std::jthread([this](std::stop_token token) {
+            _run(token);
+        });
+    }
+
+    ~UdpEgress() {
+        request_stop();
+        join();
+    }
+
+    UdpEgress(const UdpEgress&) = delete;
+    UdpEgress& operator=(const UdpEgress&) = delete;
+
+    void request_stop() noexcept {
+        _thread.request_stop();
+    }
+
+    // Only waits: egress finishes once the ring is closed and drained, or
+    // after request_stop().
+    void join() {
+        if (_thread.joinable())
+            _thread.join();
+    }
+
+    int error() const noexcept {
+        return _error.load(std::memory_order_acquire);
+    }
+
+    RingIoStats stats() const noexcept {
+        return {_items.load(std::memory_order_relaxed),
+            _bytes.load(std::memory_order_relaxed),
+            _calls.load(std::memory_order_relaxed)};
+    }
+
+private:
+    void _run(const std::stop_token& token) {
+        std::vector<Datagram> batch;
+        batch.reserve(_options.batch);
+        while (!error()) {
+            batch.clear();
+            if (!_ring->pop_front_wait_n(std::back_inserter(batch),
+                    _options.batch, token)) {
+                if (token.stop_requested() || _ring->closed())
+                    break;
+                continue;
+            }
+            _send(batch, token);
+            _recycle(batch);
+        }
+        while (!error()) {
+            batch.clear();
+            if (!_ring->pop_front_n(std::back_inserter(batch),
+                    _options.batch))
+                break;
+            _send(batch, token);
+            _recycle(batch);
+        }
+    }
+
+    void _recycle(std::vector<Datagram>& batch) {
+        if (_options.pool)
+            _options.pool->release(batch.begin(), batch.end());
+    }
+
+    void _send(std::vector<Datagram>& batch, const std::stop_token& token) {
+        _headers.resize(batch.size());
+        _iov.resize(batch.size());
+        for (size_t i = 0; i < batch.size(); ++i) {
+            auto& datagram = batch[i];
+            _iov[i] = {datagram.data.data(), datagram.data.size()};
+            _headers[i] = {};
+            if (datagram.address_size) {
+                _headers[i].msg_hdr.msg_name = &datagram.address;
+                _headers[i].msg_hdr.msg_namelen = datagram.address_size;
+            }
+            _headers[i].msg_hdr.msg_iov = &_iov[i];
+            _headers[i].msg_hdr.msg_iovlen = 1;
+        }
+        size_t sent = 0;
+        while (sent < batch.size()) {
+            auto count = ::sendmmsg(_fd, _headers.data() + sent,
+                static_cast<unsigned>(batch.size() - sent), MSG_DONTWAIT);
+            _calls.fetch_add(1, std::memory_order_relaxed);
+            if (count < 0) {
+                if (errno == EINTR)
+                    continue;
+                if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                    if (_writable(token))
+                        continue;
+                    if (!error())
+                        _error.store(ECANCELED, std::memory_order_release);
+                    return;
+                }
+                _error.store(errno, std::memory_order_release);
+                return;
+            }
+            size_t bytes = 0;
+            for (int i = 0; i < count; ++i)
+                bytes += _headers[sent + i].msg_len;
+            sent += static_cast<size_t>(count);
+            _items.fetch_add(static_cast<size_t>(count),
+                std::memory_order_relaxed);
+            _bytes.fetch_add(bytes, std::memory_order_relaxed);
+        }
+    }
+
+    // Same wait as RingSink's: false once a stop is requested.
+    bool _writable(const std::stop_token& token) {
+        for (;;) {
+            pollfd wait{_fd, POLLOUT, 0};
+            auto ready = ::poll(&wait, 1, 100);
+            if (ready > 0)
+                return true;
+            if (ready < 0 && errno != EINTR) {
+                _error.store(errno, std::memory_order_release);
+                return false;
+            }
+            if (token.stop_requested())
+                return false;
+        }
+    }
+
+    ring* _ring;
+    int _fd;
+    UdpOptions _options;
+    std::vector<mmsghdr> _headers;
+    std::vector<iovec> _iov;
+    std::atomic<int> _error{0};
+    std::atomic<uint64_t> _items{0};
+    std::atomic<uint64_t> _bytes{0};
+    std::atomic<uint64_t> _calls{0};
+    std::jthread _thread;
+};
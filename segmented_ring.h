@@ -0,0 +1,280 @@
+#pragma once
+#include <chrono> /* duration */
+#include <condition_variable> /* condition_variable */
+#include <cstdint> /* uint64_t */
+#include <memory> /* unique_ptr */
+#include <mutex> /* lock_guard unique_lock */
+#include <new> /* launder */
+#include <optional> /* optional */
+#include <stop_token> /* stop_token stop_callback */
+#include <utility> /* exchange */
+#include <vector> /* vector */
+
+using namespace std::chrono_literals;
+
+// Unbounded queue made of fixed-size ring segments linked head to tail.
+// Nothing is ever evicted; a segment that drains goes back to a small
+// per-ring cache and is reused before the allocator is asked for another,
+// so bursts cycle through the same chunks. An optional soft limit makes
+// the blocking pushes wait for room instead of growing without bound.
+template<class T>
+class SegmentedRing {
+public:
+    using lock_guard = std::lock_guard<std::mutex>;
+    using unique_lock = std::unique_lock<std::mutex>;
+
+    struct Stats {
+        size_t size = 0;
+        size_t segments = 0; /* linked, holding elements */
+        size_t cached = 0;
+        uint64_t allocated = 0; /* segments taken from the allocator */
+    };
+
+    // `soft_limit` of 0 means no backpressure.
+    SegmentedRing(size_t segment = 1024, size_t soft_limit = 0,
+        size_t cache = 4)
+        : _segment(segment ? segment : 1), _soft_limit(soft_limit),
+          _cache_limit(cache) {}
+
+    ~SegmentedRing() {
+        while (_head) {
+            while (_head->head != _head->tail)
+                _head->slot(_head->head++)->~T();
+            delete std::exchange(_head, _head->next);
+        }
+        for (auto segment : _cache)
+            delete segment;
+    }
+
+    SegmentedRing(const SegmentedRing&) = delete;
+    SegmentedRing& operator=(const SegmentedRing&) = delete;
+
+    size_t segment_size() const noexcept {
+        return _segment;
+    }
+
+    size_t size() {
+        lock_guard lock(_mutex);
+        return _size;
+    }
+
+    bool empty() {
+        return size() == 0;
+    }
+
+    void set_soft_limit(size_t limit) {
+        {
+            lock_guard lock(_mutex);
+            _soft_limit = limit;
+        }
+        _room.notify_all();
+    }
+
+    // Blocks while the soft limit is reached.
+    void push_back(T &&value) {
+        emplace_back(std::move(value));
+    }
+
+    void push_back(const T &value) {
+        emplace_back(value);
+    }
+
+    template <class... Args>
+    void emplace_back(Args&&... args) {
+        {
+            unique_lock lock(_mutex);
+            _room.wait(lock, [&] { return _has_room(); });
+            _admit(std::forward<Args>(args)...);
+        }
+        _cv.notify_one();
+    }
+
+    // Gives up when the soft limit is reached.
+    template <class... Args>
+    bool try_emplace_back(Args&&... args) {
+        {
+            lock_guard lock(_mutex);
+            if (!_has_room())
+                return false;
+            _admit(std::forward<Args>(args)...);
+        }
+        _cv.notify_one();
+        return true;
+    }
+
+    // Waits for room until `token` is stopped; false if it was.
+    bool push_back_wait(T value, const std::stop_token& token) {
+        std::stop_callback wake(token, [this] {
+            { lock_guard lock(_mutex); }
+            _room.notify_all();
+        });
+        {
+            unique_lock lock(_mutex);
+            _room.wait(lock, [&] {
+                return _has_room() || token.stop_requested();
+            });
+            if (!_has_room())
+                return false;
+            _admit(std::move(value));
+        }
+        _cv.notify_one();
+        return true;
+    }
+
+    std::optional<T> pop_front() {
+        std::optional<T> value;
+        {
+            lock_guard lock(_mutex);
+            if (!_size)
+                return std::nullopt;
+            value.emplace(_take());
+        }
+        _room.notify_one();
+        return value;
+    }
+
+    std::optional<T> pop_front_wait_for(
+        std::chrono::duration<double> duration = 100ms) {
+        std::optional<T> value;
+        {
+            unique_lock lock(_mutex);
+            if (!_cv.wait_for(lock, duration, [&] { return _size != 0; }))
+                return std::nullopt;
+            value.emplace(_take());
+        }
+        _room.notify_one();
+        return value;
+    }
+
+    std::optional<T> pop_front_wait(const std::stop_token& token) {
+        std::stop_callback wake(token, [this] {
+            { lock_guard lock(_mutex); }
+            _cv.notify_all();
+        });
+        std::optional<T> value;
+        {
+            unique_lock lock(_mutex);
+            _cv.wait(lock, [&] {
+                return _size != 0 || token.stop_requested();
+            });
+            if (!_size)
+                return std::nullopt;
+            value.emplace(_take());
+        }
+        _room.notify_one();
+        return value;
+    }
+
+    template <class OutputIt>
+    size_t pop_front_n(OutputIt out, size_t n) {
+        size_t count = 0;
+        {
+            lock_guard lock(_mutex);
+            for (; count < n && _size; ++count)
+                *out++ = _take();
+        }
+        if (count)
+            _room.notify_all();
+        return count;
+    }
+
+    Stats stats() {
+        lock_guard lock(_mutex);
+        return {_size, _segments, _cache.size(), _allocated};
+    }
+
+    // Drained segments are kept up to the cache limit, the rest freed.
+    void clear() {
+        {
+            lock_guard lock(_mutex);
+            while (_size)
+                _take();
+        }
+        _room.notify_all();
+    }
+
+private:
+    struct Segment {
+        explicit Segment(size_t size) : slots(new Slot[size]) {}
+
+        T* slot(size_t i) noexcept {
+            return std::launder(reinterpret_cast<T*>(slots[i].data));
+        }
+
+        struct Slot {
+            alignas(T) unsigned char data[sizeof(T)];
+        };
+
+        std::unique_ptr<Slot[]> slots;
+        size_t head = 0;
+        size_t tail = 0;
+        Segment* next = nullptr;
+    };
+
+    bool _has_room() const noexcept {
+        return !_soft_limit || _size < _soft_limit;
+    }
+
+    template <class... Args>
+    void _admit(Args&&... args) {
+        if (!_tail || _tail->tail == _segment) {
+            auto segment = _acquire();
+            (_tail ? _tail->next : _head) = segment;
+            _tail = segment;
+            ++_segments;
+        }
+        new (_tail->slots[_tail->tail].data) T(std::forward<Args>(args)...);
+        ++_tail->tail;
+        ++_size;
+    }
+
+    T _take() {
+        auto slot = _head->slot(_head->head++);
+        T value = std::move(*slot);
+        slot->~T();
+        --_size;
+        if (_head->head == _head->tail) {
+            if (_head == _tail) {
+                /* the only segment drained: rewind it in place */
+                _head->head = _head->tail = 0;
+            } else {
+                _release(std::exchange(_head, _head->next));
+                --_segments;
+            }
+        }
+        return value;
+    }
+
+    Segment* _acquire() {
+        if (_cache.empty()) {
+            ++_allocated;
+            return new Segment(_segment);
+        }
+        auto segment = _cache.back();
+        _cache.pop_back();
+        return segment;
+    }
+
+    void _release(Segment* segment) {
+        if (_cache.size() >= _cache_limit) {
+            delete segment;
+            return;
+        }
+        segment->head = segment->tail = 0;
+        segment->next = nullptr;
+        _cache.push_back(segment);
+    }
+
+    size_t _segment;
+    size_t _soft_limit;
+    size_t _cache_limit;
+    size_t _size = 0;
+    size_t _segments = 0;
+    uint64_t _allocated = 0;
+    Segment* _head = nullptr;
+    Segment* _tail = nullptr;
+    std::vector<Segment*> _cache;
+    std::mutex _mutex;
+    std::condition_variable _cv;
+    std::condition_variable _room;
+};
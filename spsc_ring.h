@@ -0,0 +1,156 @@
+#pragma once
+#include "ring_index.h"
+#include <atomic> /* atomic */
+#include <cstdint> /* uint64_t */
+#include <memory> /* unique_ptr */
+#include <new> /* launder */
+#include <optional> /* optional */
+#include <thread> /* yield */
+#include <type_traits> /* is_trivially_copyable_v */
+
+// Bounded single-producer single-consumer ring. Both sides are wait-free:
+// each owns one cursor and only reads the other's, so neither can be held
+// up by the other being preempted. Storage is allocated once in the
+// constructor; nothing on either hot path allocates or locks.
+template<class T>
+class SpscRing {
+public:
+    // The consumer half that may run on a real-time thread. It can only be
+    // formed for element types whose pop is a plain memcpy, so neither a
+    // move constructor nor a destructor can sneak in a lock or free().
+    class RtConsumer {
+    public:
+        static_assert(std::is_trivially_copyable_v<T> &&
+                      std::is_trivially_destructible_v<T>,
+            "SpscRing::RtConsumer needs a trivially copyable element");
+        static_assert(std::atomic<uint64_t>::is_always_lock_free,
+            "SpscRing::RtConsumer needs lock-free 64-bit atomics");
+
+        bool try_pop(T& value) noexcept {
+            return _ring->_try_pop_n(&value, 1) == 1;
+        }
+
+        size_t try_pop_n(T* out, size_t n) noexcept {
+            return _ring->_try_pop_n(out, n);
+        }
+
+        size_t size() const noexcept {
+            return _ring->size();
+        }
+
+    private:
+        friend class SpscRing;
+
+        explicit RtConsumer(SpscRing* ring) noexcept : _ring(ring) {}
+
+        SpscRing* _ring;
+    };
+
+    // The slot count is always a power of two; `capacity` is the limit.
+    SpscRing(size_t capacity = 1024)
+        : _index(capacity, true),
+          _at{_index.slots() - 1},
+          _slots(new Slot[_index.slots()]) {}
+
+    ~SpscRing() {
+        while (try_pop()) {}
+    }
+
+    SpscRing(const SpscRing&) = delete;
+    SpscRing& operator=(const SpscRing&) = delete;
+
+    size_t max_size() const noexcept {
+        return _index.capacity();
+    }
+
+    // _head is loaded first: it never passes _tail, so the difference
+    // cannot wrap when read from a thread that is neither side. Both sides
+    // may move between the loads, hence the clamp.
+    size_t size() const noexcept {
+        auto head = _head.load(std::memory_order_acquire);
+        auto size = _tail.load(std::memory_order_acquire) - head;
+        return size < _index.capacity() ? size : _index.capacity();
+    }
+
+    bool empty() const noexcept {
+        return size() == 0;
+    }
+
+    RtConsumer rt_consumer() noexcept {
+        return RtConsumer(this);
+    }
+
+    // Producer side.
+    template <class... Args>
+    bool try_emplace(Args&&... args) {
+        auto tail = _tail.load(std::memory_order_relaxed);
+        if (tail - _head_cache >= _index.capacity()) {
+            _head_cache = _head.load(std::memory_order_acquire);
+            if (tail - _head_cache >= _index.capacity())
+                return false;
+        }
+        new (_slots[_at(tail)].data) T(std::forward<Args>(args)...);
+        _tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool try_push(const T& value) {
+        return try_emplace(value);
+    }
+
+    bool try_push(T&& value) {
+        return try_emplace(std::move(value));
+    }
+
+    // Producer side, for the non real-time thread: yields until there is
+    // room.
+    void push(T value) {
+        while (!try_emplace(std::move(value)))
+            std::this_thread::yield();
+    }
+
+    // Consumer side.
+    std::optional<T> try_pop() noexcept(
+        std::is_nothrow_move_constructible_v<T>) {
+        auto head = _head.load(std::memory_order_relaxed);
+        if (head == _tail_cache) {
+            _tail_cache = _tail.load(std::memory_order_acquire);
+            if (head == _tail_cache)
+                return std::nullopt;
+        }
+        auto& slot = *_slot(head);
+        std::optional<T> value(std::move(slot));
+        slot.~T();
+        _head.store(head + 1, std::memory_order_release);
+        return value;
+    }
+
+private:
+    struct Slot {
+        alignas(T) unsigned char data[sizeof(T)];
+    };
+
+    T* _slot(uint64_t sequence) noexcept {
+        return std::launder(
+            reinterpret_cast<T*>(_slots[_at(sequence)].data));
+    }
+
+    size_t _try_pop_n(T* out, size_t n) noexcept {
+        auto head = _head.load(std::memory_order_relaxed);
+        if (_tail_cache - head < n)
+            _tail_cache = _tail.load(std::memory_order_acquire);
+        auto count = _tail_cache - head < n ? _tail_cache - head : n;
+        for (size_t i = 0; i < count; ++i)
+            out[i] = *_slot(head + i);
+        _head.store(head + count, std::memory_order_release);
+        return count;
+    }
+
+    RingIndex _index;
+    RingIndex::Masked _at;
+    std::unique_ptr<Slot[]> _slots;
+    alignas(64) std::atomic<uint64_t> _head{0};
+    uint64_t _tail_cache = 0; /* consumer's view of _tail */
+    alignas(64) std::atomic<uint64_t> _tail{0};
+    uint64_t _head_cache = 0; /* producer's view of _head */
+};
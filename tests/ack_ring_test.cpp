@@ -0,0 +1,47 @@
+#include "ack_ring.h"
+#include "check.h"
+#include <thread>
+
+using Nack = AckRing<int>::Nack;
+
+int main() {
+    AckRing<int> ring(3);
+    ring.push_back(1);
+    auto first = ring.pop_front_ack();
+    CHECK(first && first->value == 1);
+    ring.push_back(2);
+    ring.push_back(3);
+    ring.push_back(4);
+    CHECK(ring.in_flight() == 1);
+
+    /* a full ring refuses the requeue instead of evicting 4 */
+    CHECK(ring.nack(first->seq) == Nack::full);
+    CHECK(ring.stats().evicted == 0);
+    CHECK(ring.in_flight() == 1);
+    CHECK(*ring.pop_front() == 2);
+    CHECK(ring.nack(first->seq) == Nack::requeued);
+    CHECK(ring.nack(first->seq) == Nack::unknown);
+    CHECK(*ring.pop_front() == 1);
+    CHECK(*ring.pop_front() == 3);
+    CHECK(*ring.pop_front() == 4);
+
+    /* ack releases, expiry requeues only what fits, oldest first */
+    for (int i = 10; i < 13; ++i)
+        ring.push_back(i);
+    auto a = ring.pop_front_ack();
+    auto b = ring.pop_front_ack();
+    auto c = ring.pop_front_ack();
+    CHECK(ring.ack(b->seq));
+    CHECK(!ring.ack(b->seq));
+    ring.push_back(20);
+    ring.push_back(21);
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    CHECK(ring.requeue_expired(std::chrono::milliseconds(1)) == 1);
+    CHECK(ring.in_flight() == 1);
+    CHECK(*ring.pop_front() == a->value);
+    CHECK(ring.requeue_expired(std::chrono::milliseconds(1)) == 1);
+    CHECK(*ring.pop_front() == c->value);
+    CHECK(ring.in_flight() == 0);
+    CHECK(ring.ack_upto(c->seq) == 0);
+    return 0;
+}
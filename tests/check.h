@@ -0,0 +1,16 @@
+#pragma once
+#include <cstdio> /* fprintf */
+#include <cstdlib> /* exit */
+
+// Unlike assert() this stays on in release builds.
+#define CHECK(expr)                                                        \
+    do {                                                                   \
+        if (!(expr)) {                                                     \
+            std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__,    \
+                __LINE__, #expr);                                          \
+            std::exit(1);                                                  \
+        }                                                                  \
+    } while (0)
+
+// Exit code ctest reports as skipped.
+constexpr int skipped = 77;
@@ -0,0 +1,131 @@
+#include "claim_ring.h"
+#include "check.h"
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+int main() {
+    for (bool pow2 : {false, true}) {
+        ClaimRing<int> ring(10, pow2);
+        CHECK(ring.max_size() == 10);
+        bool threw = false;
+        try {
+            ring.claim(11);
+        } catch (const std::length_error&) {
+            threw = true;
+        }
+        CHECK(threw);
+
+        /* claims publish in order, even when a later one finishes first */
+        auto first = ring.claim(3);
+        {
+            auto second = ring.claim(2);
+            second[0] = 3;
+            second[1] = 4;
+            std::jthread later([&] { second.publish(); });
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            CHECK(ring.empty());
+            for (size_t i = 0; i < first.size(); ++i)
+                first[i] = static_cast<int>(i);
+            first.publish();
+        }
+        CHECK(ring.size() == 5);
+        std::vector<int> out;
+        CHECK(ring.pop_front_n(std::back_inserter(out), 10) == 5);
+        CHECK((out == std::vector<int>{0, 1, 2, 3, 4}));
+
+        /* a claim across the end of the slot array comes in two spans */
+        std::vector<int> values{5, 6, 7, 8, 9, 10, 11, 12};
+        ring.push_back(values.begin(), values.end());
+        out.clear();
+        ring.pop_front_n(std::back_inserter(out), 8);
+        CHECK(out == values);
+        auto wrapped = ring.claim(ring.max_size());
+        auto spans = wrapped.spans();
+        CHECK(spans[0].size() + spans[1].size() == ring.max_size());
+        CHECK(!spans[1].empty());
+        for (size_t i = 0; i < wrapped.size(); ++i)
+            wrapped[i] = static_cast<int>(i);
+        wrapped.publish();
+        for (int i = 0; i < 10; ++i)
+            CHECK(ring.pop_front() == i);
+        CHECK(!ring.pop_front());
+    }
+
+    /* an abandoned claim is stepped over, not delivered */
+    {
+        ClaimRing<int> ring(8);
+        ring.push_back(1);
+        ring.claim(3); /* dropped unfilled */
+        ring.push_back(2);
+        {
+            auto claim = ring.claim(2);
+            claim[0] = 9;
+        }
+        ring.push_back(3);
+        CHECK(ring.size() == 8);
+        std::vector<int> out;
+        CHECK(ring.pop_front_n(std::back_inserter(out), 8) == 3);
+        CHECK((out == std::vector<int>{1, 2, 3}));
+        CHECK(ring.empty());
+
+        /* also when the source throws halfway through push_back(I, I) */
+        struct Throwing {
+            int operator*() const {
+                if (value == 2)
+                    throw std::runtime_error("source");
+                return value;
+            }
+            Throwing& operator++() {
+                ++value;
+                return *this;
+            }
+            Throwing operator++(int) {
+                return {value++};
+            }
+            bool operator==(const Throwing&) const = default;
+            using difference_type = std::ptrdiff_t;
+            using value_type = int;
+            using pointer = const int*;
+            using reference = int;
+            using iterator_category = std::input_iterator_tag;
+            int value;
+        };
+        bool threw = false;
+        try {
+            ring.push_back(Throwing{0}, Throwing{4});
+        } catch (const std::runtime_error&) {
+            threw = true;
+        }
+        CHECK(threw);
+        ring.push_back(4);
+        CHECK(ring.pop_front() == 4);
+        CHECK(!ring.pop_front());
+    }
+
+    /* producers block while full and nothing is lost or reordered */
+    constexpr int per_producer = 20000;
+    ClaimRing<std::pair<int, int>> shared(64, true);
+    std::vector<std::jthread> producers;
+    for (int p = 0; p < 4; ++p) {
+        producers.emplace_back([&shared, p] {
+            for (int i = 0; i < per_producer; i += 4) {
+                auto claim = shared.claim(4);
+                for (int k = 0; k < 4; ++k)
+                    claim[k] = {p, i + k};
+                claim.publish();
+            }
+        });
+    }
+    std::vector<int> next(4, 0);
+    for (int got = 0; got < 4 * per_producer;) {
+        auto value = shared.pop_front();
+        if (!value) {
+            std::this_thread::yield();
+            continue;
+        }
+        CHECK(value->second == next[value->first]++);
+        ++got;
+    }
+    return 0;
+}
@@ -0,0 +1,45 @@
+#include "clock_cache.h"
+#include "check.h"
+#include <string>
+
+int main() {
+    ClockCache<int, std::string> cache(4);
+    CHECK(cache.max_size() == 4);
+    for (int i = 0; i < 4; ++i)
+        CHECK(!cache.put(i, std::to_string(i)));
+    CHECK(cache.size() == 4);
+
+    /* a hit spares the entry from the next sweep */
+    CHECK(cache.get(0) == "0");
+    auto evicted = cache.put(4, "4");
+    CHECK(evicted && evicted->first == 1);
+    CHECK(cache.contains(0) && !cache.contains(1));
+
+    /* overwriting keeps the size and evicts nothing */
+    CHECK(!cache.put(4, "four"));
+    CHECK(cache.get(4) == "four");
+    CHECK(cache.size() == 4);
+
+    /* erased slots are reused before anything is evicted */
+    CHECK(cache.erase(2));
+    CHECK(!cache.erase(2));
+    CHECK(!cache.put(5, "5"));
+    CHECK(cache.get(1) == std::nullopt);
+
+    auto stats = cache.stats();
+    CHECK(stats.size == 4 && stats.evicted == 1);
+    CHECK(stats.hits == 2 && stats.misses == 1);
+
+    /* colliding keys survive backward-shift deletion */
+    ClockCache<int, int> many(64);
+    for (int i = 0; i < 64; ++i)
+        many.put(i * 128, i);
+    for (int i = 0; i < 64; i += 2)
+        CHECK(many.erase(i * 128));
+    for (int i = 1; i < 64; i += 2)
+        CHECK(many.get(i * 128) == i);
+
+    cache.clear();
+    CHECK(cache.empty() && !cache.contains(0));
+    return 0;
+}
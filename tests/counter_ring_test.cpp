@@ -0,0 +1,41 @@
+#include "counter_ring.h"
+#include "check.h"
+
+int main() {
+    using clock = std::chrono::steady_clock;
+    for (bool pow2 : {false, true}) {
+        CounterRing<> counter(10, 1s, pow2);
+        CHECK(counter.buckets() == 10);
+        auto now = clock::now();
+
+        /* one add per second for 20 seconds */
+        for (int i = 0; i < 20; ++i)
+            counter.add(1, now + std::chrono::seconds(i));
+        auto end = now + 19s;
+        CHECK(counter.total(1s, end) == 1);
+        CHECK(counter.total(5s, end) == 5);
+        CHECK(counter.total(10s, end) == 10);
+        /* windows are capped at the ring length */
+        CHECK(counter.total(60s, end) == 10);
+        CHECK(counter.rate(5s, end) == 1.0);
+
+        /* buckets older than the ring are not counted */
+        CHECK(counter.total(10s, end + 5s) == 5);
+        CHECK(counter.total(10s, end + 10s) == 0);
+
+        /* a recycled bucket starts over */
+        counter.add(7, end + 30s);
+        CHECK(counter.total(1s, end + 30s) == 7);
+
+        counter.reset();
+        CHECK(counter.total(10s) == 0);
+    }
+
+    /* a bucket idle for 2^24 widths is not mistaken for a current one */
+    CounterRing<> fine(8, 1ms);
+    auto now = clock::now();
+    fine.add(3, now);
+    CHECK(fine.total(1ms, now) == 3);
+    CHECK(fine.total(8ms, now + std::chrono::milliseconds(1 << 24)) == 0);
+    return 0;
+}
@@ -0,0 +1,74 @@
+#include "disruptor.h"
+#include "check.h"
+#include <atomic>
+#include <thread>
+
+namespace {
+
+struct Event {
+    uint64_t input = 0;
+    uint64_t doubled = 0;
+    uint64_t squared = 0;
+};
+
+} // namespace
+
+int main() {
+    /* try_publish() refuses once the slowest terminal stage is a ring behind */
+    for (bool pow2 : {false, true}) {
+        Disruptor<Event> small(10, pow2);
+        auto& stage = small.add_stage();
+        size_t published = 0;
+        while (small.try_publish([](Event&) {}))
+            ++published;
+        CHECK(published == small.max_size());
+        CHECK(stage.process([](Event&, uint64_t) {}, 3) == 3);
+        CHECK(small.try_publish([](Event&) {}));
+        CHECK(stage.sequence() == 3);
+    }
+
+    /* a diamond: two stages on the producer, a third behind both of them */
+    constexpr uint64_t count = 200000;
+    Disruptor<Event> disruptor(64);
+    auto& doubler = disruptor.add_stage();
+    auto& squarer = disruptor.add_stage();
+    auto& joiner = disruptor.add_stage({&doubler, &squarer});
+    std::atomic<uint64_t> checked{0};
+    std::atomic<bool> ordered{true};
+    {
+        std::jthread a([&](std::stop_token token) {
+            while (doubler.process_wait([](Event& event, uint64_t) {
+                event.doubled = event.input * 2;
+            }, token)) {
+            }
+        });
+        std::jthread b([&](std::stop_token token) {
+            while (squarer.process_wait([](Event& event, uint64_t) {
+                event.squared = event.input * event.input;
+            }, token)) {
+            }
+        });
+        std::jthread c([&](std::stop_token token) {
+            uint64_t expected = 0;
+            while (joiner.process_wait([&](Event& event, uint64_t sequence) {
+                if (sequence != expected++ || event.input != sequence ||
+                    event.doubled != sequence * 2 ||
+                    event.squared != sequence * sequence)
+                    ordered = false;
+                ++checked;
+            }, token)) {
+            }
+        });
+        for (uint64_t i = 0; i < count; ++i) {
+            CHECK(disruptor.publish([i](Event& event) {
+                event.input = i;
+            }) == i);
+        }
+        while (joiner.sequence() != count)
+            std::this_thread::yield();
+    }
+    CHECK(ordered);
+    CHECK(checked == count);
+    CHECK(disruptor.sequence() == count);
+    return 0;
+}
@@ -0,0 +1,51 @@
+#include "edf_scheduler.h"
+#include "check.h"
+#include <string>
+#include <thread>
+
+int main() {
+    Ring<std::string> bulk(100), interactive(100);
+    EdfScheduler<std::string> scheduler;
+    auto slow = scheduler.add(bulk, 1s);
+    auto fast = scheduler.add(interactive, 10ms);
+    CHECK(!scheduler.pop());
+
+    /* later arrivals with a tighter budget go first */
+    bulk.push_back("b0");
+    bulk.push_back("b1");
+    std::this_thread::sleep_for(1ms);
+    interactive.push_back("i0");
+    interactive.push_back("i1");
+    for (auto expected : {"i0", "i1", "b0", "b1"}) {
+        auto item = scheduler.pop();
+        CHECK(item && item->value == expected);
+        CHECK(item->id == (expected[0] == 'i' ? fast : slow));
+    }
+    CHECK(!scheduler.pop());
+
+    /* a head served after its deadline counts as missed */
+    interactive.push_back("late");
+    std::this_thread::sleep_for(20ms);
+    bulk.push_back("early");
+    auto item = scheduler.pop();
+    CHECK(item && item->value == "late");
+    CHECK(scheduler.stats(fast).served == 3);
+    CHECK(scheduler.stats(fast).missed == 1);
+    CHECK(scheduler.pop()->value == "early");
+    CHECK(scheduler.stats(slow).missed == 0);
+
+    /* pop_wait() wakes on a push to any ring and returns on stop */
+    std::jthread producer([&] {
+        std::this_thread::sleep_for(10ms);
+        bulk.push_back("woken");
+    });
+    std::stop_source stop;
+    item = scheduler.pop_wait(stop.get_token());
+    CHECK(item && item->value == "woken" && item->id == slow);
+    std::jthread stopper([&] {
+        std::this_thread::sleep_for(10ms);
+        stop.request_stop();
+    });
+    CHECK(!scheduler.pop_wait(stop.get_token()));
+    return 0;
+}
@@ -0,0 +1,49 @@
+#include "fair_ring.h"
+#include "check.h"
+#include <string>
+
+int main() {
+    FairRing<std::string, int> ring(100, 3);
+    ring.set_weight(1, 2);
+    for (int i = 0; i < 4; ++i) {
+        ring.push_back(1, "a" + std::to_string(i));
+        ring.push_back(2, "b" + std::to_string(i));
+    }
+    /* tenant cap 3: the oldest of each was evicted */
+    CHECK(ring.size() == 6);
+    CHECK(ring.stats().evicted == 2);
+    CHECK(ring.size(1) == 3);
+
+    /* weight 2 against weight 1 */
+    std::string order;
+    while (auto value = ring.pop_front())
+        order += (*value)[0];
+    CHECK(order == "aabab" "b");
+    CHECK(ring.stats().tenants == 0);
+
+    /* drained tenants with the default weight are forgotten */
+    CHECK(ring.stats().known == 1);
+    for (int tenant = 0; tenant < 1000; ++tenant)
+        ring.push_back(tenant + 10, "x");
+    /* overflow evicted 900 of them, and those are forgotten too */
+    CHECK(ring.stats().known == 101);
+    while (ring.pop_front()) {}
+    CHECK(ring.stats().known == 1);
+    ring.push_back(5, "y");
+    CHECK(ring.stats().known == 2);
+    ring.clear();
+    CHECK(ring.empty());
+    CHECK(ring.stats().known == 1);
+
+    /* overflow evicts from the largest tenant */
+    FairRing<int, int> shared(4, 10);
+    shared.push_back(1, 1);
+    shared.push_back(2, 1);
+    shared.push_back(2, 2);
+    shared.push_back(2, 3);
+    shared.push_back(1, 2);
+    CHECK(shared.size() == 4);
+    CHECK(shared.size(2) == 2);
+    CHECK(shared.size(1) == 2);
+    return 0;
+}
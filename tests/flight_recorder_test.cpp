@@ -0,0 +1,196 @@
+#include "flight_recorder.h"
+#include "check.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <semaphore.h>
+#include <signal.h>
+#include <string>
+#include <sys/mman.h>
+#include <thread>
+#include <vector>
+
+namespace {
+
+struct Record {
+    uint32_t thread;
+    uint32_t value;
+};
+
+std::string dump(const FlightRecorder<Record>& recorder) {
+    int pipe[2];
+    CHECK(::pipe(pipe) == 0);
+    CHECK(recorder.dump(pipe[1]));
+    ::close(pipe[1]);
+    std::string bytes;
+    char buffer[4096];
+    ssize_t got;
+    while ((got = ::read(pipe[0], buffer, sizeof(buffer))) > 0)
+        bytes.append(buffer, static_cast<size_t>(got));
+    ::close(pipe[0]);
+    return bytes;
+}
+
+struct Large {
+    uint64_t words[4096];
+};
+
+// Dumps `recorder` and checks that every record it accepts was written by
+// one push. Returns how many were accepted.
+uint64_t check_large(const FlightRecorder<Large>& recorder) {
+    auto file = std::tmpfile();
+    CHECK(file && recorder.dump(::fileno(file)));
+    std::rewind(file);
+    FlightRecorderHeader header;
+    CHECK(std::fread(&header, sizeof(header), 1, file) == 1);
+    uint64_t accepted = 0;
+    for (uint64_t i = 0; i < header.count; ++i) {
+        uint64_t sequence;
+        Large record;
+        CHECK(std::fread(&sequence, sizeof(sequence), 1, file) == 1);
+        CHECK(std::fread(&record, sizeof(record), 1, file) == 1);
+        if (sequence == FlightRecorderHeader::torn)
+            continue;
+        for (auto word : record.words)
+            CHECK(word == record.words[0]);
+        ++accepted;
+    }
+    std::fclose(file);
+    return accepted;
+}
+
+// A push whose source record straddles a PROT_NONE page faults halfway
+// through its copy; the handler parks it there until the test resumes it.
+sem_t paused;
+sem_t resume;
+
+void park(int) {
+    sem_post(&paused);
+    while (sem_wait(&resume) != 0) {
+    }
+}
+
+} // namespace
+
+int main() {
+    /* capacity rounds up and only the newest records are dumped */
+    FlightRecorder<Record> recorder(100);
+    CHECK(recorder.max_size() == 128);
+    for (uint32_t i = 0; i < 300; ++i)
+        recorder.push({0, i});
+    auto bytes = dump(recorder);
+    FlightRecorderHeader header;
+    constexpr size_t entry = sizeof(uint64_t) + sizeof(Record);
+    CHECK(bytes.size() == sizeof(header) + 128 * entry);
+    std::memcpy(&header, bytes.data(), sizeof(header));
+    CHECK(header.magic == FlightRecorderHeader::signature);
+    CHECK(header.record_size == sizeof(Record));
+    CHECK(header.next == 300 && header.count == 128);
+    for (size_t i = 0; i < header.count; ++i) {
+        uint64_t sequence;
+        Record record;
+        auto at = bytes.data() + sizeof(header) + i * entry;
+        std::memcpy(&sequence, at, sizeof(sequence));
+        std::memcpy(&record, at + sizeof(sequence), sizeof(record));
+        CHECK(sequence == 172 + i);
+        CHECK(record.value == sequence);
+    }
+
+    /* concurrent pushes each get their own sequence number */
+    FlightRecorder<Record> shared(1024);
+    std::vector<std::jthread> threads;
+    for (uint32_t t = 0; t < 4; ++t) {
+        threads.emplace_back([&shared, t] {
+            for (uint32_t i = 0; i < 10000; ++i)
+                shared.push({t, i});
+        });
+    }
+    threads.clear();
+    CHECK(shared.pushed() == 40000);
+    bytes = dump(shared);
+    std::memcpy(&header, bytes.data(), sizeof(header));
+    CHECK(header.count == 1024);
+    for (size_t i = 0; i < header.count; ++i) {
+        uint64_t sequence;
+        std::memcpy(&sequence, bytes.data() + sizeof(header) + i * entry,
+            sizeof(sequence));
+        /* a push that gave up on its slot shows as torn, never as another */
+        CHECK(sequence == 40000 - 1024 + i ||
+            sequence == FlightRecorderHeader::torn);
+    }
+
+    /* writers lapped while copying a large record never leave a mix of two
+       records behind a valid stamp */
+    FlightRecorder<Large> lapped(2);
+    std::atomic<bool> done{false};
+    std::atomic<uint64_t> checked{0};
+    std::jthread reader([&] {
+        while (!done.load())
+            checked += check_large(lapped);
+    });
+    for (uint32_t t = 0; t < 4; ++t) {
+        threads.emplace_back([&lapped, t] {
+            Large record;
+            for (uint32_t i = 0; i < 2000; ++i) {
+                std::fill(std::begin(record.words), std::end(record.words),
+                    (uint64_t(t) << 32) | i);
+                lapped.push(record);
+            }
+        });
+    }
+    threads.clear();
+    done = true;
+    reader.join();
+    checked += check_large(lapped);
+    CHECK(checked > 0);
+
+    /* a push that laps a writer still copying gives up instead of writing
+       into the same slot, and its sequence is dumped as torn */
+    FlightRecorder<Large> slow(2);
+    Large record;
+    std::fill(std::begin(record.words), std::end(record.words), 1);
+    slow.push(record);
+    auto half = sizeof(Large) / 2;
+    auto source = static_cast<char*>(::mmap(nullptr, sizeof(Large),
+        PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+    CHECK(source != MAP_FAILED);
+    std::fill_n(reinterpret_cast<uint64_t*>(source), 4096, 2);
+    CHECK(::mprotect(source + half, half, PROT_NONE) == 0);
+    sem_init(&paused, 0, 0);
+    sem_init(&resume, 0, 0);
+    struct sigaction action{};
+    action.sa_handler = park;
+    CHECK(::sigaction(SIGSEGV, &action, nullptr) == 0);
+    std::jthread writer([&] {
+        CHECK(slow.push(*reinterpret_cast<const Large*>(source)));
+    });
+    while (sem_wait(&paused) != 0) {
+    }
+    std::fill(std::begin(record.words), std::end(record.words), 3);
+    CHECK(slow.push(record)); /* sequence 2, the other slot */
+    std::fill(std::begin(record.words), std::end(record.words), 4);
+    CHECK(!slow.push(record)); /* sequence 3, the writer's slot */
+    CHECK(::mprotect(source + half, half, PROT_READ | PROT_WRITE) == 0);
+    sem_post(&resume);
+    writer.join();
+    action.sa_handler = SIG_DFL;
+    ::sigaction(SIGSEGV, &action, nullptr);
+    CHECK(slow.pushed() == 4);
+    auto file = std::tmpfile();
+    CHECK(file && slow.dump(::fileno(file)));
+    std::rewind(file);
+    CHECK(std::fread(&header, sizeof(header), 1, file) == 1);
+    CHECK(header.count == 2);
+    for (uint64_t expected : {2, 3}) {
+        uint64_t sequence;
+        CHECK(std::fread(&sequence, sizeof(sequence), 1, file) == 1);
+        CHECK(std::fread(&record, sizeof(record), 1, file) == 1);
+        if (expected == 2)
+            CHECK(sequence == 2 && record.words[0] == 3);
+        else
+            CHECK(sequence == FlightRecorderHeader::torn);
+    }
+    std::fclose(file);
+    ::munmap(source, sizeof(Large));
+    return 0;
+}
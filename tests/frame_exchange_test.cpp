@@ -0,0 +1,64 @@
+#include "frame_exchange.h"
+#include "check.h"
+#include <thread>
+#include <vector>
+
+int main() {
+    /* frames are built once and only their indices move */
+    FrameExchange<std::vector<int>> exchange(3, size_t(4), 0);
+    CHECK(exchange.max_size() == 3);
+    for (int i = 0; i < 3; ++i) {
+        auto frame = exchange.acquire();
+        CHECK(frame && (*frame)->size() == 4);
+        (**frame)[0] = i;
+        frame->publish();
+    }
+
+    /* a lagging consumer costs the oldest frame */
+    auto frame = exchange.acquire();
+    CHECK(frame);
+    (**frame)[0] = 3;
+    frame->publish();
+    CHECK(exchange.stats().dropped == 1);
+    {
+        auto oldest = exchange.acquire_oldest();
+        CHECK(oldest && (**oldest)[0] == 1);
+    }
+    {
+        auto latest = exchange.acquire_latest();
+        CHECK(latest && (**latest)[0] == 3);
+        /* the frame being read is never recycled under the reader */
+        for (int i = 0; i < 5; ++i) {
+            auto write = exchange.acquire();
+            CHECK(write && write->index() != latest->index());
+            write->publish();
+        }
+    }
+    auto stats = exchange.stats();
+    CHECK(stats.published == 9 && stats.consumed == 2);
+    CHECK(stats.dropped == 5);
+
+    /* an unpublished write lease leaves nothing behind */
+    while (exchange.acquire_oldest()) {
+    }
+    exchange.acquire();
+    CHECK(!exchange.acquire_oldest());
+
+    /* waiting readers wake on publish and on stop */
+    std::jthread producer([&] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        auto write = exchange.acquire();
+        (**write)[0] = 42;
+        write->publish();
+    });
+    auto got = exchange.acquire_latest_wait_for(std::chrono::seconds(5));
+    CHECK(got && (**got)[0] == 42);
+    got.reset();
+    std::stop_source stop;
+    std::jthread stopper([&] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        stop.request_stop();
+    });
+    CHECK(!exchange.acquire_oldest_wait(stop.get_token()));
+    return 0;
+}
@@ -0,0 +1,26 @@
+#include "perf_counters.h"
+#include "check.h"
+#include <sstream>
+
+int main() {
+    PerfCounters counters; /* may open nothing in a container */
+    counters.start();
+    counters.stop();
+    auto reading = counters.read();
+    CHECK(counters.available() || !reading.values[PerfCounters::cycles]);
+
+    PerfReport report;
+    report.add({"plain", 1, 10, 0.5, {}});
+    report.add({"a,\"b\"\n", 2, 20, 1, reading});
+
+    std::ostringstream csv;
+    report.write_csv(csv);
+    CHECK(csv.str().find("\nplain,1,10,0.5,") != std::string::npos);
+    CHECK(csv.str().find("\n\"a,\"\"b\"\"\n\",2,20,1,") != std::string::npos);
+
+    std::ostringstream json;
+    report.write_json(json);
+    CHECK(json.str().find("\"benchmark\": \"a,\\\"b\\\"\\u000a\"") !=
+        std::string::npos);
+    return 0;
+}
@@ -0,0 +1,65 @@
+#include "ring.h"
+#include "check.h"
+#include <thread>
+#include <vector>
+
+int main() {
+    /* target 5ms, interval 200ms; the sleeps leave 25ms or more of slack */
+    Ring<int> ring(1000);
+    ring.set_aqm(5ms, 200ms);
+    std::vector<int> popped;
+    auto pop = [&] {
+        auto value = ring.pop_front();
+        CHECK(value);
+        popped.push_back(*value);
+        return ring.stats().dropped;
+    };
+    for (int i = 0; i < 100; ++i)
+        ring.push_back(i);
+
+    /* below target, then above it for less than an interval: no drops */
+    CHECK(pop() == 0);
+    std::this_thread::sleep_for(10ms);
+    CHECK(pop() == 0);
+
+    /* above target for a whole interval: the head is dropped */
+    std::this_thread::sleep_for(210ms);
+    CHECK(pop() == 1);
+    CHECK(pop() == 1);
+
+    /* later drops follow interval / sqrt(count) */
+    std::this_thread::sleep_for(210ms);
+    CHECK(pop() == 2);
+    std::this_thread::sleep_for(150ms);
+    CHECK(pop() == 3);
+
+    /* the last element is never dropped, and popping it ends dropping */
+    while (!ring.empty())
+        pop();
+    CHECK(ring.stats().dropped == 3);
+    CHECK(popped.back() == 99);
+
+    /* re-entering soon after keeps the previous drop rate: the next drop
+       comes interval / sqrt(2) later, not a whole interval */
+    for (int i = 100; i < 200; ++i)
+        ring.push_back(i);
+    std::this_thread::sleep_for(10ms);
+    CHECK(pop() == 3);
+    std::this_thread::sleep_for(210ms);
+    CHECK(pop() == 4);
+    std::this_thread::sleep_for(170ms);
+    CHECK(pop() == 5);
+
+    /* a zero target turns it off */
+    ring.set_aqm(0s);
+    std::this_thread::sleep_for(30ms);
+    while (!ring.empty())
+        pop();
+    CHECK(ring.stats().dropped == 5);
+
+    /* nothing is reordered and every element is either popped or dropped */
+    for (size_t i = 1; i < popped.size(); ++i)
+        CHECK(popped[i - 1] < popped[i]);
+    CHECK(popped.size() + 5 == 200);
+    return 0;
+}
@@ -0,0 +1,60 @@
+#include "ring.h"
+#include "check.h"
+#include <vector>
+
+namespace {
+
+struct Update {
+    int key;
+    int sum;
+};
+
+bool merge(Update& back, const Update& value) {
+    if (back.key != value.key)
+        return false;
+    back.sum += value.sum;
+    return true;
+}
+
+} // namespace
+
+int main() {
+    Ring<Update> ring(3);
+    ring.set_combiner(merge);
+
+    /* a matching back element absorbs the push */
+    ring.push_back({1, 1});
+    ring.push_back({1, 2});
+    CHECK(ring.size() == 1);
+    /* otherwise the value takes a new slot */
+    ring.push_back({2, 5});
+    ring.push_back({1, 4});
+    CHECK(ring.size() == 3);
+    auto stats = ring.stats();
+    CHECK(stats.combined == 1 && stats.pushed == 3);
+
+    /* merging into a full ring evicts nothing */
+    ring.push_back({1, 10});
+    CHECK(ring.stats().evicted == 0 && ring.stats().combined == 2);
+
+    /* push_back_n merges run by run and counts only new slots */
+    std::vector<Update> batch{{1, 1}, {3, 1}, {3, 1}, {3, 1}, {1, 1}};
+    CHECK(ring.push_back_n(batch.begin(), batch.end()) == 2);
+    CHECK(ring.stats().combined == 5);
+    std::vector<Update> out;
+    while (auto value = ring.pop_front())
+        out.push_back(*value);
+    CHECK(out.size() == 3);
+    CHECK(out[0].key == 1 && out[0].sum == 15);
+    CHECK(out[1].key == 3 && out[1].sum == 3);
+    CHECK(out[2].key == 1 && out[2].sum == 1);
+    CHECK(ring.stats().evicted == 2);
+
+    /* an empty function turns combining off */
+    ring.set_combiner({});
+    ring.push_back({1, 1});
+    ring.push_back({1, 1});
+    CHECK(ring.size() == 2);
+    CHECK(ring.stats().combined == 5);
+    return 0;
+}
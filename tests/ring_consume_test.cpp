@@ -0,0 +1,62 @@
+#include "ring.h"
+#include "check.h"
+#include <thread>
+#include <vector>
+
+int main() {
+    /* the range drains in batches and ends once closed and drained */
+    Ring<int> ring(100);
+    for (int i = 0; i < 10; ++i)
+        ring.push_back(i);
+    ring.close();
+    ring.push_back(10); /* still accepted after close */
+    std::vector<int> seen;
+    for (auto& value : ring.consume({}, 3))
+        seen.push_back(value);
+    CHECK(seen.size() == 11);
+    for (int i = 0; i <= 10; ++i)
+        CHECK(seen[i] == i);
+    CHECK(ring.empty());
+
+    /* a stop ends it after the batch in hand; the rest stays queued */
+    Ring<int> open(100);
+    for (int i = 0; i < 10; ++i)
+        open.push_back(i);
+    std::stop_source stop;
+    seen.clear();
+    for (auto& value : open.consume(stop.get_token(), 4)) {
+        seen.push_back(value);
+        stop.request_stop();
+    }
+    CHECK((seen == std::vector<int>{0, 1, 2, 3}));
+    CHECK(open.size() == 6);
+
+    /* a parked range wakes for pushes from another thread, then for close */
+    Ring<int> fed(100);
+    std::jthread producer([&] {
+        for (int i = 0; i < 100; ++i)
+            fed.push_back(i);
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        fed.close();
+    });
+    seen.clear();
+    for (auto& value : fed.consume({}, 16))
+        seen.push_back(value);
+    CHECK(seen.size() == 100 && seen.back() == 99);
+
+    /* a default-constructed iterator compares equal to the end */
+    Ring<int>::ConsumeRange::iterator none;
+    CHECK(none == std::default_sentinel);
+
+#if defined(__cpp_lib_generator)
+    Ring<int> generated(100);
+    for (int i = 0; i < 5; ++i)
+        generated.push_back(i);
+    generated.close();
+    int expected = 0;
+    for (auto&& value : generated.consume_generator({}, 2))
+        CHECK(value == expected++);
+    CHECK(expected == 5);
+#endif
+    return 0;
+}
@@ -0,0 +1,62 @@
+#include "ring.h"
+#include "check.h"
+#include <atomic>
+#include <system_error>
+#include <thread>
+
+int main() {
+    constexpr int count = 100000;
+    Ring<int> ring(count);
+    for (int i = 0; i < count; ++i)
+        ring.push_back(i);
+
+    /* join() waits for the queued work instead of abandoning it */
+    std::atomic<long long> sum{0};
+    ConsumerOptions options;
+    options.threads = 4;
+    auto consumer = ring.spawn_consumer([&](std::span<int> batch) {
+        long long local = 0;
+        for (auto value : batch)
+            local += value;
+        sum += local;
+    }, options);
+    ring.close();
+    consumer.join();
+    CHECK(ring.empty());
+    CHECK(consumer.stats().items == count);
+    CHECK(sum == 1LL * count * (count - 1) / 2);
+
+    /* request_stop() ends the threads with work still queued */
+    Ring<int> open(16);
+    auto idle = open.spawn_consumer([](int) {});
+    idle.request_stop();
+    idle.join();
+    CHECK(!idle.joinable());
+
+#if defined(__linux__)
+    /* pinning happens before the first pop and failures are reported */
+    std::atomic<int> cpu{-1};
+    options = {};
+    options.cpus = {0};
+    Ring<int> pinned(16);
+    pinned.push_back(1);
+    {
+        auto handle = pinned.spawn_consumer([&](int) {
+            cpu = sched_getcpu();
+        }, options);
+        pinned.close();
+        handle.join();
+    }
+    CHECK(cpu == 0);
+
+    options.cpus = {-1};
+    bool refused = false;
+    try {
+        auto handle = pinned.spawn_consumer([](int) {}, options);
+    } catch (const std::system_error&) {
+        refused = true;
+    }
+    CHECK(refused);
+#endif
+    return 0;
+}
@@ -0,0 +1,93 @@
+#include "ring_io.h"
+#include "check.h"
+#include <fcntl.h>
+#include <string>
+#include <thread>
+
+namespace {
+
+std::span<const char> as_bytes(const std::string& value) {
+    return value;
+}
+
+size_t split_lines(std::span<const char> bytes,
+    std::vector<std::string>& lines) {
+    size_t start = 0;
+    for (size_t i = 0; i < bytes.size(); ++i) {
+        if (bytes[i] == '\n') {
+            lines.emplace_back(bytes.data() + start, i - start);
+            start = i + 1;
+        }
+    }
+    return start;
+}
+
+} // namespace
+
+int main() {
+    /* lines go through a pipe and come back in order */
+    constexpr int count = 20000;
+    int pipe[2];
+    CHECK(::pipe(pipe) == 0);
+    Ring<std::string> in(count), out(count);
+    {
+        RingIoOptions options;
+        options.close_on_eof = true;
+        RingSource<std::string> source(out, pipe[0], split_lines, options);
+        {
+            options = {};
+            options.linger = std::chrono::milliseconds(1);
+            RingSink<std::string> sink(in, pipe[1], as_bytes, options);
+            for (int i = 0; i < count; ++i)
+                in.push_back(std::to_string(i) + "\n");
+            in.close();
+            sink.join();
+            CHECK(sink.error() == 0);
+            CHECK(sink.stats().items == count);
+        }
+        ::close(pipe[1]);
+        while (!out.closed())
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        source.join();
+        CHECK(source.eof());
+        CHECK(source.error() == 0);
+    }
+    ::close(pipe[0]);
+    CHECK(out.size() == count);
+    for (int i = 0; i < count; ++i)
+        CHECK(*out.pop_front() == std::to_string(i));
+
+    /* aligned output is whole blocks, the last one zero-padded */
+    CHECK(::pipe(pipe) == 0);
+    Ring<std::string> blocks(16);
+    {
+        RingIoOptions options;
+        options.align = 512;
+        RingSink<std::string> sink(blocks, pipe[1], as_bytes, options);
+        for (int i = 0; i < 6; ++i)
+            blocks.push_back(std::string(100, 'a'));
+    }
+    std::string written(2048, '\0');
+    auto got = ::read(pipe[0], written.data(), written.size());
+    CHECK(got == 1024);
+    CHECK(written[599] == 'a' && written[600] == '\0');
+    ::close(pipe[0]);
+    ::close(pipe[1]);
+
+    /* a stop is seen when nobody reads the pipe; the fd stays blocking */
+    CHECK(::pipe(pipe) == 0);
+    Ring<std::string> stalled(64);
+    {
+        RingSink<std::string> sink(stalled, pipe[1], as_bytes);
+        for (int i = 0; i < 64; ++i)
+            stalled.push_back(std::string(64 * 1024, 'x'));
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        CHECK(!(::fcntl(pipe[1], F_GETFL) & O_NONBLOCK));
+        sink.request_stop();
+        sink.join();
+        CHECK(sink.error() == ECANCELED);
+    }
+    ::close(pipe[0]);
+    ::close(pipe[1]);
+    return 0;
+}
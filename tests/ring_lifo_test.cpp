@@ -0,0 +1,52 @@
+#include "ring.h"
+#include "check.h"
+#include <thread>
+
+int main() {
+    /* occupancy: LIFO from 4 queued, back to FIFO at 2 */
+    Ring<int> ring(100);
+    ring.set_adaptive_lifo(4);
+    for (int i = 1; i <= 6; ++i)
+        ring.push_back(i);
+    for (int expected : {6, 5, 4, 3}) {
+        CHECK(ring.pop_next() == expected);
+        CHECK(ring.stats().lifo);
+    }
+    CHECK(ring.pop_next() == 1);
+    CHECK(!ring.stats().lifo);
+    CHECK(ring.pop_next() == 2);
+    CHECK(ring.stats().lifo_switches == 2);
+
+    /* a small occupancy still leaves LIFO while elements stay queued */
+    ring.set_adaptive_lifo(2);
+    for (int i = 0; i < 200; ++i) {
+        ring.push_back(2 * i);
+        ring.push_back(2 * i + 1);
+        CHECK(ring.pop_next() == 2 * i + 1);
+        CHECK(ring.pop_next() == 2 * i);
+        CHECK(!ring.stats().lifo);
+    }
+    CHECK(ring.stats().lifo_switches == 2 + 400);
+
+    /* age: LIFO once the ring has been busy too long, FIFO after it drains */
+    ring.set_adaptive_lifo(0, 20ms);
+    auto switches = ring.stats().lifo_switches;
+    ring.push_back(0);
+    std::this_thread::sleep_for(30ms);
+    ring.push_back(1);
+    ring.push_back(2);
+    CHECK(ring.pop_next() == 2);
+    CHECK(ring.stats().lifo);
+    for (int i = 3; i < 10; ++i) {
+        ring.push_back(i);
+        CHECK(ring.pop_next() == i);
+    }
+    CHECK(ring.pop_next() == 1);
+    CHECK(ring.pop_next() == 0);
+    ring.push_back(10);
+    ring.push_back(11);
+    CHECK(ring.pop_next() == 10);
+    CHECK(!ring.stats().lifo);
+    CHECK(ring.stats().lifo_switches == switches + 2);
+    return 0;
+}
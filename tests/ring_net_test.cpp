@@ -0,0 +1,117 @@
+#include "ring_net.h"
+#include "check.h"
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+int main() {
+    int rx = ::socket(AF_INET, SOCK_DGRAM, 0);
+    int tx = ::socket(AF_INET, SOCK_DGRAM, 0);
+    if (rx < 0 || tx < 0)
+        return skipped;
+    int buffer = 8 << 20;
+    ::setsockopt(rx, SOL_SOCKET, SO_RCVBUF, &buffer, sizeof(buffer));
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    auto name = reinterpret_cast<sockaddr*>(&address);
+    socklen_t size = sizeof(address);
+    if (::bind(rx, name, size) != 0 || ::getsockname(rx, name, &size) != 0 ||
+        ::connect(tx, name, size) != 0)
+        return skipped;
+
+    /* datagrams sent by UdpEgress arrive through UdpIngest in order */
+    constexpr int count = 2000;
+    Ring<Datagram> outbound(count), inbound(count);
+    std::vector<Datagram> received;
+    {
+        UdpIngest ingest(inbound, rx);
+        {
+            UdpEgress egress(outbound, tx);
+            for (int i = 0; i < count; ++i) {
+                Datagram datagram;
+                auto text = std::to_string(i);
+                datagram.data.assign(text.begin(), text.end());
+                outbound.push_back(std::move(datagram));
+                /* stay under the loopback socket buffer */
+                if (i % 100 == 99)
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            outbound.close();
+            egress.join();
+            CHECK(egress.error() == 0);
+            CHECK(egress.stats().items == count);
+            CHECK(egress.stats().calls < count);
+        }
+        while (received.size() < count) {
+            auto datagram = inbound.pop_front_wait_for(std::chrono::seconds(5));
+            CHECK(datagram);
+            received.push_back(std::move(*datagram));
+        }
+        ingest.request_stop();
+        ingest.join();
+        CHECK(ingest.error() == 0);
+        CHECK(ingest.stats().items == count);
+    }
+    for (int i = 0; i < count; ++i) {
+        auto& datagram = received[i];
+        CHECK(std::string(datagram.data.begin(), datagram.data.end()) ==
+            std::to_string(i));
+        CHECK(datagram.address_size > 0);
+    }
+
+    /* longer datagrams are cut to UdpOptions::size */
+    {
+        UdpOptions options;
+        options.size = 8;
+        UdpIngest ingest(inbound, rx, options);
+        std::string text(100, 'x');
+        CHECK(::send(tx, text.data(), text.size(), 0) == 100);
+        auto datagram = inbound.pop_front_wait_for(std::chrono::seconds(5));
+        CHECK(datagram && datagram->data.size() == 8);
+        ingest.request_stop();
+    }
+
+    /* UdpEgress returns the buffers it sent to the pool */
+    DatagramPool pool(64);
+    UdpOptions options;
+    options.pool = &pool;
+    Ring<Datagram> queued(100);
+    {
+        UdpEgress egress(queued, tx, options);
+        for (int i = 0; i < 100; ++i) {
+            Datagram datagram;
+            datagram.data.reserve(options.size);
+            datagram.data.push_back('y');
+            queued.push_back(std::move(datagram));
+        }
+        queued.close();
+        egress.join();
+        CHECK(egress.stats().items == 100);
+    }
+    CHECK(pool.size() == 64);
+
+    /* UdpIngest refills from it, and consumers give buffers back */
+    received.clear();
+    {
+        UdpIngest ingest(inbound, rx, options);
+        while (received.size() < 100) {
+            auto datagram = inbound.pop_front_wait_for(std::chrono::seconds(5));
+            CHECK(datagram);
+            received.push_back(std::move(*datagram));
+        }
+        ingest.request_stop();
+        ingest.join();
+    }
+    CHECK(pool.size() == 0);
+    for (auto& datagram : received) {
+        CHECK(datagram.data.size() == 1 && datagram.data[0] == 'y');
+        pool.release(std::move(datagram));
+    }
+    CHECK(pool.size() == 64);
+    ::close(rx);
+    ::close(tx);
+    return 0;
+}
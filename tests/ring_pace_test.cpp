@@ -0,0 +1,63 @@
+#include "ring.h"
+#include "check.h"
+#include <thread>
+#include <vector>
+
+int main() {
+    using clock = std::chrono::steady_clock;
+    std::stop_source never;
+
+    /* 41 pops at 200/s with no burst take about 200ms */
+    Ring<int> ring(1000);
+    for (int i = 0; i < 41; ++i)
+        ring.push_back(i);
+    auto start = clock::now();
+    for (int i = 0; i < 41; ++i)
+        CHECK(ring.pop_front_paced(200, 1, never.get_token()) == i);
+    auto elapsed = clock::now() - start;
+    CHECK(elapsed >= 180ms && elapsed < 400ms);
+
+    /* an idle bucket fills up to the burst and no further */
+    for (int i = 0; i < 10; ++i)
+        ring.push_back(i);
+    std::this_thread::sleep_for(100ms);
+    start = clock::now();
+    for (int i = 0; i < 5; ++i)
+        CHECK(ring.pop_front_paced(100, 5, never.get_token()) == i);
+    CHECK(clock::now() - start < 5ms);
+    CHECK(ring.pop_front_paced(100, 5, never.get_token()) == 5);
+    CHECK(clock::now() - start >= 8ms);
+
+    /* the batch form takes every whole token at once, up to n */
+    ring.clear();
+    for (int i = 0; i < 100; ++i)
+        ring.push_back(i);
+    std::vector<int> out;
+    std::this_thread::sleep_for(100ms);
+    CHECK(ring.pop_front_paced_n(std::back_inserter(out), 100, 100, 5,
+        never.get_token()) == 5);
+    CHECK(ring.pop_front_paced_n(std::back_inserter(out), 3, 1000, 50,
+        never.get_token()) >= 1);
+    CHECK(out.size() <= 8 && out[0] == 0 && out[5] == 5);
+
+    /* with no rate a parked pop returns on stop and on close */
+    Ring<int> paused(10);
+    paused.push_back(0);
+    paused.push_back(1);
+    CHECK(paused.pop_front_paced(1000, 1, never.get_token()) == 0);
+    std::stop_source stop;
+    std::jthread stopper([&] {
+        std::this_thread::sleep_for(10ms);
+        stop.request_stop();
+    });
+    CHECK(!paused.pop_front_paced(0, 1, stop.get_token()));
+    std::jthread closer([&] {
+        std::this_thread::sleep_for(10ms);
+        paused.close();
+    });
+    CHECK(!paused.pop_front_paced_n(std::back_inserter(out), 10, 0, 1,
+        never.get_token()));
+    CHECK(!paused.pop_front_paced(0, 1, never.get_token()));
+    CHECK(paused.size() == 1);
+    return 0;
+}
@@ -0,0 +1,94 @@
+#include "ring.h"
+#include "check.h"
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+int main() {
+    using clock = Ring<int>::clock;
+    Ring<int> ring(100);
+    ring.set_timestamps(true);
+    /* each push is stamped inside its own [before, after] window */
+    std::vector<std::pair<clock::time_point, clock::time_point>> pushed;
+    auto push = [&](int value) {
+        auto before = clock::now();
+        ring.push_back(value);
+        pushed.emplace_back(before, clock::now());
+    };
+    auto pop = [&](int expected) {
+        auto popped = ring.pop_front_timed();
+        CHECK(popped && popped->second == expected);
+        CHECK(popped->first >= pushed[expected].first &&
+              popped->first <= pushed[expected].second);
+    };
+    for (int i = 0; i < 20; ++i)
+        push(i);
+    CHECK(ring.count_if([](int v) { return v % 2; }) == 10);
+    CHECK(!ring.pop_front_if([](int v) { return v == 1; }));
+    CHECK(*ring.pop_front_if([](int v) { return v == 0; }) == 0);
+    CHECK(ring.erase_if([](int v) { return v % 3 == 0; }) == 6);
+    CHECK(ring.erase_if([](int v) { return v > 100; }) == 0);
+
+    /* order and timestamps survive the compaction */
+    for (int expected : {1, 2, 4, 5, 7, 8, 10, 11, 13, 14, 16, 17, 19})
+        pop(expected);
+    CHECK(ring.empty());
+
+    /* a throwing predicate keeps what it had not judged yet */
+    pushed.clear();
+    for (int i = 0; i < 10; ++i)
+        push(i);
+    bool threw = false;
+    try {
+        ring.erase_if([](int v) {
+            if (v == 5)
+                throw std::runtime_error("pred");
+            return v % 2 == 0;
+        });
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    CHECK(threw);
+    CHECK(ring.size() == 7);
+    for (int expected : {1, 3, 5, 6, 7, 8, 9})
+        pop(expected);
+    CHECK(ring.empty());
+
+    Ring<std::string> names(10);
+    for (int i = 0; i < 10; ++i)
+        names.push_back(std::to_string(i));
+    CHECK(names.erase_if([](const std::string& v) { return v < "5"; }) == 5);
+    for (int i = 5; i < 10; ++i)
+        CHECK(*names.pop_front() == std::to_string(i));
+    CHECK(names.erase_if([](const std::string&) { return true; }) == 0);
+
+    for (int i = 0; i < 10; ++i)
+        names.push_back(std::to_string(i));
+    threw = false;
+    try {
+        names.erase_if([](const std::string& v) {
+            if (v == "6")
+                throw std::runtime_error("pred");
+            return v < "3";
+        });
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    CHECK(threw);
+    CHECK(names.size() == 7);
+    for (int i = 3; i < 10; ++i)
+        CHECK(*names.pop_front() == std::to_string(i));
+
+    /* nothing erased before the throw leaves the ring as it was */
+    for (int i = 0; i < 3; ++i)
+        names.push_back(std::to_string(i));
+    try {
+        names.erase_if([](const std::string&) -> bool {
+            throw std::runtime_error("pred");
+        });
+    } catch (const std::runtime_error&) {
+    }
+    CHECK(names.size() == 3);
+    CHECK(*names.pop_front() == "0");
+    return 0;
+}
@@ -0,0 +1,46 @@
+#include "ring.h"
+#include "check.h"
+#include <cmath>
+#include <thread>
+
+int main() {
+    /* about 1000 pushes a second for 300ms, nothing popped */
+    Ring<int> ring(100000);
+    ring.set_rate_window(50ms);
+    for (int round = 0; round < 30; ++round) {
+        for (int i = 0; i < 10; ++i)
+            ring.push_back(i);
+        std::this_thread::sleep_for(10ms);
+    }
+    auto stats = ring.stats();
+    CHECK(stats.arrival_rate > 400 && stats.arrival_rate < 1200);
+    CHECK(stats.service_rate < 50);
+    auto room = static_cast<double>(stats.capacity - stats.size);
+    auto expected = room / (stats.arrival_rate - stats.service_rate);
+    CHECK(std::isfinite(stats.time_to_overflow.count()));
+    CHECK(std::abs(stats.time_to_overflow.count() - expected) <
+        0.01 * expected);
+    /* filling: it never drains */
+    CHECK(std::isinf(stats.drain_eta.count()));
+
+    /* about 1000 pops a second, nothing pushed */
+    for (int round = 0; round < 25; ++round) {
+        for (int i = 0; i < 10; ++i)
+            CHECK(ring.pop_front());
+        std::this_thread::sleep_for(10ms);
+    }
+    stats = ring.stats();
+    CHECK(stats.service_rate > 400 && stats.service_rate < 1200);
+    CHECK(stats.arrival_rate < 50);
+    CHECK(std::isfinite(stats.drain_eta.count()));
+    CHECK(stats.drain_eta.count() > 0 && stats.drain_eta.count() < 1);
+    /* draining: it never overflows */
+    CHECK(std::isinf(stats.time_to_overflow.count()));
+    CHECK(std::isinf(ring.time_to_overflow().count()));
+
+    /* idle: both rates decay towards zero */
+    std::this_thread::sleep_for(400ms);
+    stats = ring.stats();
+    CHECK(stats.arrival_rate < 5 && stats.service_rate < 5);
+    return 0;
+}
@@ -0,0 +1,46 @@
+#include "ring.h"
+#include "check.h"
+#include <string>
+#include <vector>
+
+static std::vector<std::string> drain(Ring<std::string>& ring) {
+    std::vector<std::string> out;
+    while (auto value = ring.pop_front())
+        out.push_back(std::move(*value));
+    return out;
+}
+
+int main() {
+    Ring<std::string> ring(3);
+    ring.push_back("1");
+    ring.push_back("2");
+    ring.push_back("3");
+    ring.push_back("4"); /* evicts the oldest */
+    CHECK(ring.size() == 3);
+    CHECK(ring.stats().evicted == 1);
+    CHECK(*ring.pop_front() == "2");
+    CHECK(*ring.pop_back() == "4");
+    ring.push_front("0");
+    CHECK((drain(ring) == std::vector<std::string>{"0", "3"}));
+
+    /* resize keeps the prefix, from either side of the midpoint */
+    for (size_t keep : {1, 2, 7, 9}) {
+        Ring<std::string> big(10);
+        for (int i = 0; i < 10; ++i)
+            big.push_back(std::to_string(i));
+        big.resize(keep);
+        CHECK(big.max_size() == keep);
+        auto rest = drain(big);
+        CHECK(rest.size() == keep);
+        for (size_t i = 0; i < keep; ++i)
+            CHECK(rest[i] == std::to_string(i));
+    }
+
+    std::vector<std::string> values{"a", "b"};
+    ring.assign(values.begin(), values.end());
+    CHECK(ring.size() == 2);
+    ring.clear();
+    CHECK(ring.empty());
+    CHECK(!ring.pop_front_wait_for(std::chrono::milliseconds(1)));
+    return 0;
+}
@@ -0,0 +1,65 @@
+#include "segmented_ring.h"
+#include "check.h"
+#include <string>
+#include <thread>
+
+namespace {
+
+std::string item(int i) {
+    /* long enough to live on the heap */
+    return std::string(32, 'x') + std::to_string(i);
+}
+
+} // namespace
+
+int main() {
+    SegmentedRing<std::string> ring(4, 0, 2);
+    for (int i = 0; i < 10; ++i)
+        ring.push_back(item(i));
+    auto stats = ring.stats();
+    CHECK(stats.size == 10 && stats.segments == 3 && stats.allocated == 3);
+
+    /* drained segments go to the cache and come back before new ones */
+    std::vector<std::string> out;
+    CHECK(ring.pop_front_n(std::back_inserter(out), 8) == 8);
+    stats = ring.stats();
+    CHECK(stats.segments == 1 && stats.cached == 2);
+    for (int i = 10; i < 18; ++i)
+        ring.emplace_back(item(i));
+    stats = ring.stats();
+    CHECK(stats.segments == 3 && stats.cached == 0 && stats.allocated == 3);
+    for (int i = 8; i < 18; ++i)
+        CHECK(ring.pop_front() == item(i));
+    CHECK(!ring.pop_front());
+    CHECK(ring.stats().segments == 1);
+
+    /* the soft limit refuses or blocks pushes instead of growing */
+    ring.set_soft_limit(2);
+    CHECK(ring.try_emplace_back(item(0)));
+    CHECK(ring.try_emplace_back(item(1)));
+    CHECK(!ring.try_emplace_back(item(2)));
+    std::stop_source stop;
+    std::jthread stopper([&] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        stop.request_stop();
+    });
+    CHECK(!ring.push_back_wait(item(2), stop.get_token()));
+    std::jthread consumer([&] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        ring.pop_front();
+    });
+    ring.push_back(item(2));
+    consumer.join();
+    CHECK(ring.pop_front() == item(1));
+    CHECK(ring.pop_front_wait_for(1s) == item(2));
+    CHECK(!ring.pop_front_wait_for(10ms));
+
+    /* a cleared ring keeps at most the cache limit of segments */
+    ring.set_soft_limit(0);
+    for (int i = 0; i < 40; ++i)
+        ring.push_back(item(i));
+    ring.clear();
+    stats = ring.stats();
+    CHECK(ring.empty() && stats.segments == 1 && stats.cached == 2);
+    return 0;
+}
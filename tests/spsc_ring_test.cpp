@@ -0,0 +1,45 @@
+#include "spsc_ring.h"
+#include "check.h"
+#include <string>
+#include <thread>
+
+int main() {
+    SpscRing<std::string> ring(3);
+    CHECK(ring.max_size() == 3);
+    CHECK(ring.try_push("a"));
+    CHECK(ring.try_push("b"));
+    CHECK(ring.try_emplace(1, 'c'));
+    CHECK(!ring.try_push("d"));
+    CHECK(ring.size() == 3);
+    CHECK(*ring.try_pop() == "a");
+    CHECK(ring.try_push("d"));
+    CHECK(*ring.try_pop() == "b");
+    CHECK(*ring.try_pop() == "c");
+    CHECK(*ring.try_pop() == "d");
+    CHECK(!ring.try_pop());
+
+    constexpr int count = 200000;
+    SpscRing<int> numbers(64);
+    std::jthread producer([&] {
+        for (int i = 0; i < count; ++i)
+            numbers.push(i);
+    });
+    /* a third thread never sees more than the capacity queued */
+    std::jthread observer([&](std::stop_token token) {
+        while (!token.stop_requested())
+            CHECK(numbers.size() <= numbers.max_size());
+    });
+    auto consumer = numbers.rt_consumer();
+    int buffer[16];
+    for (int expected = 0; expected < count;) {
+        auto n = consumer.try_pop_n(buffer, 16);
+        for (size_t i = 0; i < n; ++i)
+            CHECK(buffer[i] == expected++);
+        if (!n)
+            std::this_thread::yield();
+    }
+    observer.request_stop();
+    observer.join();
+    CHECK(numbers.empty());
+    return 0;
+}
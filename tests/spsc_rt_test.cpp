@@ -0,0 +1,49 @@
+// Runs SpscRing::RtConsumer on a SCHED_FIFO thread against a normal
+// priority producer. Skipped where real-time scheduling is not permitted.
+#include "spsc_ring.h"
+#include "check.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <pthread.h>
+#include <sched.h>
+#include <thread>
+
+int main() {
+    constexpr int count = 1000000;
+    SpscRing<int> ring(256);
+    std::atomic<int> status{0}; /* 0 - pending, 1 - running, -1 - refused */
+    int received = 0;
+    bool ordered = true;
+
+    std::jthread consumer([&] {
+        sched_param param{};
+        param.sched_priority = sched_get_priority_min(SCHED_FIFO) + 1;
+        if (pthread_setschedparam(pthread_self(), SCHED_FIFO, &param)) {
+            status = -1;
+            return;
+        }
+        status = 1;
+        auto rt = ring.rt_consumer();
+        int buffer[64];
+        while (received < count) {
+            auto n = rt.try_pop_n(buffer, 64);
+            for (size_t i = 0; i < n; ++i)
+                ordered &= buffer[i] == received++;
+            if (!n) /* let a producer sharing this CPU run */
+                std::this_thread::sleep_for(std::chrono::microseconds(50));
+        }
+    });
+    while (!status)
+        std::this_thread::yield();
+    if (status < 0) {
+        std::puts("SCHED_FIFO not permitted, skipping");
+        return skipped;
+    }
+    for (int i = 0; i < count; ++i)
+        ring.push(i);
+    consumer.join();
+    CHECK(received == count);
+    CHECK(ordered);
+    return 0;
+}
@@ -0,0 +1,70 @@
+#include "timer_wheel.h"
+#include "check.h"
+#include <algorithm>
+#include <random>
+#include <thread>
+#include <vector>
+
+int main() {
+    using clock = std::chrono::steady_clock;
+    using std::chrono::milliseconds;
+
+    /* timers on every level fire no earlier than due, in deadline order */
+    TimerWheel<int> wheel(1ms);
+    auto start = clock::now();
+    std::mt19937 random(7);
+    std::vector<int> delays;
+    for (int i = 0; i < 5000; ++i)
+        delays.push_back(static_cast<int>(random() % 400000) + 1);
+    for (auto delay : delays)
+        wheel.schedule(start + milliseconds(delay), delay);
+    CHECK(wheel.size() == delays.size());
+    std::sort(delays.begin(), delays.end());
+
+    std::vector<int> fired;
+    for (int now = 0; now < 401000; now += 997) {
+        auto before = fired.size();
+        wheel.expire(std::back_inserter(fired), start + milliseconds(now));
+        for (auto i = before; i < fired.size(); ++i)
+            CHECK(fired[i] <= now + 1);
+        auto due = std::upper_bound(delays.begin(), delays.end(), now - 1) -
+            delays.begin();
+        CHECK(fired.size() >= static_cast<size_t>(due));
+    }
+    CHECK(wheel.size() == 0);
+    CHECK(std::is_sorted(fired.begin(), fired.end()));
+    CHECK(fired == delays);
+
+    /* a cancelled timer never fires and its id goes stale */
+    TimerWheel<int> cancelling(1ms);
+    auto later = cancelling.schedule_after(10s, 1);
+    auto kept = cancelling.schedule_after(20s, 2);
+    CHECK(cancelling.cancel(later));
+    CHECK(!cancelling.cancel(later));
+    cancelling.schedule_after(10s, 3); /* reuses the cancelled slot */
+    CHECK(!cancelling.cancel(later));
+    CHECK(cancelling.size() == 2);
+    CHECK(cancelling.next_expiry().has_value());
+    fired.clear();
+    cancelling.expire(std::back_inserter(fired), clock::now() + 30s);
+    CHECK((fired == std::vector<int>{3, 2}));
+    CHECK(!cancelling.cancel(kept));
+    CHECK(!cancelling.next_expiry());
+
+    /* expire_wait() parks until the deadline or a stop */
+    TimerWheel<int> waiting(1ms);
+    waiting.schedule_after(20ms, 42);
+    auto before = clock::now();
+    fired.clear();
+    std::stop_source stop;
+    CHECK(waiting.expire_wait(std::back_inserter(fired), stop.get_token()));
+    CHECK(fired == std::vector<int>{42});
+    CHECK(clock::now() - before >= 19ms);
+    std::jthread stopper([&] {
+        std::this_thread::sleep_for(20ms);
+        stop.request_stop();
+    });
+    CHECK(waiting.expire_wait(std::back_inserter(fired), stop.get_token()) ==
+        0);
+    return 0;
+}
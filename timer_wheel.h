@@ -0,0 +1,297 @@
+#pragma once
+#include <array> /* array */
+#include <bit> /* countr_zero */
+#include <chrono> /* steady_clock */
+#include <condition_variable> /* condition_variable */
+#include <cstdint> /* uint64_t uint32_t */
+#include <limits> /* numeric_limits */
+#include <mutex> /* lock_guard unique_lock */
+#include <optional> /* optional */
+#include <stop_token> /* stop_token stop_callback */
+#include <vector> /* vector */
+
+using namespace std::chrono_literals;
+
+// Hierarchical timing wheel: four levels of 64 buckets, each a ring indexed
+// by masking the tick counter. Timers live in a slab and are linked into
+// their bucket intrusively, so schedule() and cancel() are O(1); buckets of
+// the upper levels cascade down as the lower level wraps.
+template<class T, class Clock = std::chrono::steady_clock>
+class TimerWheel {
+public:
+    using clock = Clock;
+    using duration = typename Clock::duration;
+    using time_point = typename Clock::time_point;
+    using id = uint64_t;
+    using lock_guard = std::lock_guard<std::mutex>;
+    using unique_lock = std::unique_lock<std::mutex>;
+
+    TimerWheel(duration resolution = 1ms)
+        : _resolution(resolution.count() > 0 ? resolution : duration(1)),
+          _origin(Clock::now()) {
+        _heads.fill(_nil);
+    }
+
+    TimerWheel(const TimerWheel&) = delete;
+    TimerWheel& operator=(const TimerWheel&) = delete;
+
+    duration resolution() const noexcept {
+        return _resolution;
+    }
+
+    size_t size() {
+        lock_guard lock(_mutex);
+        return _count;
+    }
+
+    id schedule(time_point deadline, T value) {
+        bool earlier;
+        id timer;
+        {
+            lock_guard lock(_mutex);
+            auto tick = _tick_ceil(deadline);
+            if (tick <= _now)
+                tick = _now + 1;
+            auto index = _allocate();
+            auto& node = _nodes[index];
+            node.value.emplace(std::move(value));
+            node.tick = tick;
+            _link(index);
+            ++_count;
+            earlier = tick < _parked;
+            timer = (uint64_t(node.generation) << 32) | index;
+        }
+        if (earlier)
+            _cv.notify_one();
+        return timer;
+    }
+
+    id schedule_after(duration delay, T value) {
+        return schedule(Clock::now() + delay, std::move(value));
+    }
+
+    bool cancel(id timer) {
+        lock_guard lock(_mutex);
+        auto index = static_cast<uint32_t>(timer);
+        if (index >= _nodes.size() ||
+            _nodes[index].generation != (timer >> 32) ||
+            !_nodes[index].value)
+            return false;
+        _unlink(index);
+        _free(index);
+        --_count;
+        return true;
+    }
+
+    // Moves the payloads of every timer due by `now` to `out`, in batches
+    // of whole buckets.
+    template <class OutputIt>
+    size_t expire(OutputIt out, time_point now = Clock::now()) {
+        lock_guard lock(_mutex);
+        return _advance(_tick_floor(now), out);
+    }
+
+    // Parks until the next non-empty bucket is due (or an earlier timer is
+    // scheduled) and then expires it. Returns 0 only on stop.
+    template <class OutputIt>
+    size_t expire_wait(OutputIt out, const std::stop_token& token) {
+        std::stop_callback wake(token, [this] {
+            { lock_guard lock(_mutex); }
+            _cv.notify_all();
+        });
+        unique_lock lock(_mutex);
+        while (!token.stop_requested()) {
+            auto tick = _next_event();
+            if (tick != _never) {
+                if (auto count = _advance(_tick_floor(Clock::now()), out))
+                    return count;
+                tick = _next_event();
+            }
+            _parked = tick;
+            if (tick == _never)
+                _cv.wait(lock);
+            else
+                _cv.wait_until(lock, _time(tick));
+            _parked = _never;
+        }
+        return 0;
+    }
+
+    // Earliest time at which expire() can return something; may be a
+    // cascade point rather than an actual deadline.
+    std::optional<time_point> next_expiry() {
+        lock_guard lock(_mutex);
+        auto tick = _next_event();
+        if (tick == _never)
+            return std::nullopt;
+        return _time(tick);
+    }
+
+private:
+    static constexpr unsigned _bits = 6;
+    static constexpr unsigned _levels = 4;
+    static constexpr uint64_t _slots = uint64_t(1) << _bits;
+    static constexpr uint64_t _mask = _slots - 1;
+    static constexpr uint32_t _nil = std::numeric_limits<uint32_t>::max();
+    static constexpr uint64_t _never = std::numeric_limits<uint64_t>::max();
+
+    struct Node {
+        std::optional<T> value;
+        uint64_t tick = 0;
+        uint32_t prev = _nil;
+        uint32_t next = _nil;
+        uint32_t bucket = 0;
+        uint32_t generation = 0;
+    };
+
+    uint64_t _tick_floor(time_point time) const noexcept {
+        if (time <= _origin)
+            return 0;
+        return static_cast<uint64_t>((time - _origin) / _resolution);
+    }
+
+    uint64_t _tick_ceil(time_point time) const noexcept {
+        if (time <= _origin)
+            return 0;
+        return static_cast<uint64_t>(
+            (time - _origin + _resolution - duration(1)) / _resolution);
+    }
+
+    time_point _time(uint64_t tick) const noexcept {
+        return _origin + _resolution * tick;
+    }
+
+    uint32_t _allocate() {
+        if (_free_list != _nil) {
+            auto index = _free_list;
+            _free_list = _nodes[index].next;
+            return index;
+        }
+        _nodes.emplace_back();
+        return static_cast<uint32_t>(_nodes.size() - 1);
+    }
+
+    void _free(uint32_t index) {
+        auto& node = _nodes[index];
+        node.value.reset();
+        ++node.generation;
+        node.prev = _nil;
+        node.next = _free_list;
+        _free_list = index;
+    }
+
+    void _link(uint32_t index) {
+        auto& node = _nodes[index];
+        auto delta = node.tick - _now;
+        unsigned level = 0;
+        while (level + 1 < _levels && delta >= (_slots << (_bits * level)))
+            ++level;
+        auto tick = node.tick;
+        if (delta >= (_slots << (_bits * level))) /* beyond the top level */
+            tick = _now + (_slots << (_bits * level)) - 1;
+        auto slot = (tick >> (_bits * level)) & _mask;
+        auto bucket = static_cast<uint32_t>(level * _slots + slot);
+        node.bucket = bucket;
+        node.prev = _nil;
+        node.next = _heads[bucket];
+        if (node.next != _nil)
+            _nodes[node.next].prev = index;
+        _heads[bucket] = index;
+        _occupied[level] |= uint64_t(1) << slot;
+    }
+
+    void _unlink(uint32_t index) {
+        auto& node = _nodes[index];
+        if (node.prev != _nil)
+            _nodes[node.prev].next = node.next;
+        else
+            _heads[node.bucket] = node.next;
+        if (node.next != _nil)
+            _nodes[node.next].prev = node.prev;
+        if (_heads[node.bucket] == _nil)
+            _occupied[node.bucket / _slots] &=
+                ~(uint64_t(1) << (node.bucket & _mask));
+    }
+
+    uint32_t _detach(uint32_t bucket) {
+        auto head = _heads[bucket];
+        _heads[bucket] = _nil;
+        _occupied[bucket / _slots] &= ~(uint64_t(1) << (bucket & _mask));
+        return head;
+    }
+
+    void _cascade(unsigned level) {
+        if (level >= _levels)
+            return;
+        auto slot = (_now >> (_bits * level)) & _mask;
+        if (slot == 0)
+            _cascade(level + 1);
+        for (auto index = _detach(level * _slots + slot); index != _nil;) {
+            auto next = _nodes[index].next;
+            _link(index);
+            index = next;
+        }
+    }
+
+    template <class OutputIt>
+    size_t _advance(uint64_t target, OutputIt& out) {
+        size_t count = 0;
+        while (_now < target) {
+            if (!_count) {
+                _now = target;
+                break;
+            }
+            auto next = _now + 1;
+            if (next & _mask) {
+                auto ahead = _occupied[0] >> (next & _mask) << (next & _mask);
+                next = ahead ? (next & ~_mask) + std::countr_zero(ahead)
+                             : (next | _mask) + 1;
+                if (next > target) {
+                    _now = target;
+                    break;
+                }
+            }
+            _now = next;
+            if (!(_now & _mask))
+                _cascade(1);
+            for (auto index = _detach(_now & _mask); index != _nil;) {
+                auto next_index = _nodes[index].next;
+                *out++ = std::move(*_nodes[index].value);
+                _free(index);
+                --_count;
+                ++count;
+                index = next_index;
+            }
+        }
+        return count;
+    }
+
+    uint64_t _next_event() const noexcept {
+        if (!_count)
+            return _never;
+        for (unsigned level = 0; level < _levels; ++level) {
+            auto shift = _bits * level;
+            auto slot = (_now >> shift) & _mask;
+            auto ahead = slot == _mask ? 0
+                : _occupied[level] >> (slot + 1) << (slot + 1);
+            if (ahead)
+                return (((_now >> shift) & ~_mask) +
+                    std::countr_zero(ahead)) << shift;
+            if (_occupied[level])
+                return (((_now >> shift) | _mask) + 1) << shift;
+        }
+        return _never;
+    }
+
+    duration _resolution;
+    time_point _origin;
+    uint64_t _now = 0;
+    uint64_t _parked = _never;
+    size_t _count = 0;
+    std::vector<Node> _nodes;
+    uint32_t _free_list = _nil;
+    std::array<uint32_t, _levels * _slots> _heads;
+    std::array<uint64_t, _levels> _occupied{};
+    std::mutex _mutex;
+    std::condition_variable _cv;
+};
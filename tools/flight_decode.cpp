@@ -0,0 +1,45 @@
+// Prints a FlightRecorder dump, one record per line: its sequence number
+// and the record bytes in hex. Reads the file named on the command line,
+// or standard input.
+#include "flight_recorder.h"
+#include <cstdio> /* fopen fread printf */
+#include <vector> /* vector */
+
+int main(int argc, char** argv) {
+    auto file = argc > 1 ? std::fopen(argv[1], "rb") : stdin;
+    if (!file) {
+        std::perror(argv[1]);
+        return 1;
+    }
+    FlightRecorderHeader header;
+    if (std::fread(&header, sizeof(header), 1, file) != 1 ||
+        header.magic != FlightRecorderHeader::signature) {
+        std::fprintf(stderr, "not a flight recorder dump\n");
+        return 1;
+    }
+    std::printf("record_size %llu slots %llu next %llu count %llu\n",
+        static_cast<unsigned long long>(header.record_size),
+        static_cast<unsigned long long>(header.slots),
+        static_cast<unsigned long long>(header.next),
+        static_cast<unsigned long long>(header.count));
+    std::vector<unsigned char> record(header.record_size);
+    for (uint64_t i = 0; i < header.count; ++i) {
+        uint64_t sequence;
+        if (std::fread(&sequence, sizeof(sequence), 1, file) != 1 ||
+            std::fread(record.data(), 1, record.size(), file) !=
+                record.size()) {
+            std::fprintf(stderr, "truncated after %llu records\n",
+                static_cast<unsigned long long>(i));
+            return 1;
+        }
+        if (sequence == FlightRecorderHeader::torn) {
+            std::printf("torn\n");
+            continue;
+        }
+        std::printf("%llu", static_cast<unsigned long long>(sequence));
+        for (auto byte : record)
+            std::printf(" %02x", byte);
+        std::printf("\n");
+    }
+    return 0;
+}